@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+// Fixed depth searches over a built-in set of positions. On one thread the search is deterministic, so the total node
+// count is a signature of the search's behavior: a change that keeps it only changed the speed. On more threads it is
+// not, and the bench measures how the search scales instead.
+namespace Bench {
+    // Depth searched when none is given.
+    constexpr int DEFAULT_DEPTH = 5;
+    // Most threads the scaling bench tries when none is given.
+    constexpr int DEFAULT_MAX_THREADS = 32;
+
+    struct BenchResult {
+        // Main search plus quiescence nodes over every position; the signature.
+        uint64_t nodes{0};
+        double seconds{0};
+
+        double nps() const noexcept { return seconds > 0 ? static_cast<double>(nodes) / seconds : 0; }
+    };
+
+    // Search every bench position to depth on threads threads, printing each position's node count to stderr if
+    // printProgress.
+    BenchResult run(int depth = DEFAULT_DEPTH, bool printProgress = true, int threads = 1);
+    // Run the bench and print the signature, time, and NPS to stdout, like Stockfish's "bench" command, followed by the
+    // hardware counters per node where available.
+    void runAndPrint(int depth = DEFAULT_DEPTH, int threads = 1);
+    // Run the bench on 1, 2, 4, ... up to maxThreads threads and print a table of the time to depth, NPS, and the
+    // speedup of each over one thread.
+    void runScaling(int depth = DEFAULT_DEPTH, int maxThreads = DEFAULT_MAX_THREADS);
+} // namespace Bench
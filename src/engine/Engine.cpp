@@ -2,60 +2,77 @@
 
 #include "Engine.hpp"
 
+#include <algorithm>
 #include <optional>
+#include <thread>
+#include <vector>
 
 SearchResult Engine::bestMove(Game& game) {
-    return search(game, 6);
+    SearchLimits limits;
+    limits.moveTime = DEFAULT_MOVE_TIME;
+    return search(game, limits);
 }
 
 int Engine::quiesce(Game& game, int alpha, int beta, int ply) { // NOLINT(misc-no-recursion)
     // increment stats
     stats_.qnodes++;
+    if(shouldStop_()) {
+        return 0;
+    }
+    // too deep to go on: mate scores stop being distinguishable from evaluations past Eval::MAX_PLY
+    if(ply >= Eval::MAX_PLY - 1) {
+        return evaluatePosition(game);
+    }
+
+    const int originalAlpha = alpha;
+    Move hashMove{};
+    int ttScore = 0;
+    // the state each move replaces, for unmaking it; every node keeps its own, so the history lives on the call stack
+    StateInfo saved;
 
     // we're in check, so position is not quiet for us; we need to resolve the check before continuing
-    if(game.isInCheck(game.sideToMove())) {
+    if(game.inCheck()) {
+        // quiescence entries have depth 0, so any stored result is deep enough to cut with
+        if(probeTT_(game, alpha, beta, 0, ply, hashMove, ttScore)) {
+            return ttScore;
+        }
+
         MoveList moves;
-        game.generatePseudoLegalMoves(moves);
+        game.generateEvasions(moves);
+
+        // No legal evasions means we've been checkmated
+        if (moves.size == 0) {
+            return -Eval::CHECKMATE + ply;
+        }
 
         // order moves to greatly improve alpha-beta pruning
         // TODO: maybe in-check specific move ordering here?
         std::array<int, MoveList::kMaxMoves> indices{};
-        orderMoves(game, moves, indices);
-
-        bool legalMoveExists = false;
+        orderMoves(game, moves, indices, hashMove);
 
+        Move bestMove{};
         for (int moveIndex = 0; moveIndex < moves.size; moveIndex++) {
             // make move from indices
             const Move move = moves.data[indices[moveIndex]];
-            const UndoInfo undoInfo = game.getUndoInfo(move);
-
-            game.makeMove(move);
-
-            // this move is not legal
-            if(game.doesMovePutUsInCheck(move)) {
-                game.undoMove(move, undoInfo);
-                continue;
-            }
 
-            // we have at least one legal move
-            legalMoveExists = true;
-            
+            game.makeMove(move, saved);
             const int score = -quiesce(game, -beta, -alpha, ply + 1);
-            game.undoMove(move, undoInfo);
+            game.unmakeMove(move, saved);
+            if(stopped_) {
+                return 0;
+            }
 
             if (score >= beta) {
+                tt_->store(game.hash(), 0, Eval::scoreToTT(score, ply), Bound::Lower, move);
                 return score;  // fail-soft
             }
             if (score > alpha) {
                 alpha = score;
+                bestMove = move;
             }
         }
 
-        // No legal evasions means we've been checkmated
-        if (!legalMoveExists) {
-            return -Eval::CHECKMATE + ply;
-        }
-
+        tt_->store(game.hash(), 0, Eval::scoreToTT(alpha, ply), alpha > originalAlpha ? Bound::Exact : Bound::Upper, bestMove);
         return alpha;
     }
 
@@ -66,49 +83,49 @@ int Engine::quiesce(Game& game, int alpha, int beta, int ply) { // NOLINT(misc-n
         return standPat;  // fail-soft
     }
 
+    // only probe once the cheap stand pat cutoff has failed; most quiescence nodes end there, and a probe is a cache miss
+    if(probeTT_(game, alpha, beta, 0, ply, hashMove, ttScore)) {
+        return ttScore;
+    }
+
     if (standPat > alpha) {
         alpha = standPat;
     }
 
-    // generate all legal moves; TODO: faster to have a dedicated generateCaptures() function here
+    // only check captures + promotions; TODO: should we also look at checks?
     MoveList moves;
-    game.generatePseudoLegalMoves(moves);
+    game.generateCaptures(moves);
 
     // order moves to greatly improve alpha-beta pruning
     // TODO: quiesce-specific move ordering here?
     std::array<int, MoveList::kMaxMoves> indices{};
-    orderMoves(game, moves, indices);
+    orderMoves(game, moves, indices, hashMove);
 
+    Move bestMove{};
     for (int moveIndex = 0; moveIndex < moves.size; moveIndex++) {
         // make move from indices
         const Move move = moves.data[indices[moveIndex]];
-        const UndoInfo undoInfo = game.getUndoInfo(move);
 
-        // only check captures + promotions; TODO: should we also look at checks?
-        if (!(move.isCapture() || move.isPromotion())) {
-            continue;
-        }
-
-        game.makeMove(move);
-
-        // this move is not legal
-        if(game.doesMovePutUsInCheck(move)) {
-            game.undoMove(move, undoInfo);
-            continue;
-        }
+        game.makeMove(move, saved);
 
         const int score = -quiesce(game, -beta, -alpha, ply + 1);
-        game.undoMove(move, undoInfo);
+        game.unmakeMove(move, saved);
+        if(stopped_) {
+            return 0;
+        }
 
         if (score >= beta) {
+            tt_->store(game.hash(), 0, Eval::scoreToTT(score, ply), Bound::Lower, move);
             return score;  // fail-soft
         }
 
         if (score > alpha) {
             alpha = score;
+            bestMove = move;
         }
     }
 
+    tt_->store(game.hash(), 0, Eval::scoreToTT(alpha, ply), alpha > originalAlpha ? Bound::Exact : Bound::Upper, bestMove);
     return alpha;
 }
 
@@ -125,62 +142,234 @@ int Engine::evaluatePosition(Game& game) const {
     return (game.sideToMove() == Color::White) ? eval : -eval;
 }
 
-SearchResult Engine::search(Game& game, int depth) {
+SearchResult Engine::search(Game& game, const SearchLimits& limits) {
+    tt_->newSearch();
+    stopHelpers_.store(false, std::memory_order_relaxed);
+
+    // Helpers search their own copy of the game until the main search is done, capped at the same depth so a fixed
+    // depth search returns a result of that depth; the clock and node limits are the main thread's alone. Odd helpers
+    // start a ply deeper, so that threads are spread over different depths and do not all search the same nodes in
+    // lockstep.
+    SearchLimits helperLimits;
+    helperLimits.depth = limits.depth;
+    std::vector<Game> helperGames(helpers_.size(), game);
+    std::vector<SearchResult> helperResults(helpers_.size());
+    std::vector<std::thread> threads;
+    for(size_t helper = 0; helper < helpers_.size(); helper++) {
+        threads.emplace_back([this, helper, &helperLimits, &helperGames, &helperResults]() {
+            const int startDepth = 1 + static_cast<int>((helper + 1) % 2);
+            helperResults[helper] = helpers_[helper]->iterate_(helperGames[helper], helperLimits, startDepth);
+        });
+    }
+
+    SearchResult result = iterate_(game, limits, 1);
+    stopHelpers_.store(true, std::memory_order_relaxed);
+    for(std::thread& thread : threads) {
+        thread.join();
+    }
+
+    // Play the deepest completed iteration of any thread; the main thread's on a tie
+    SearchStats stats = result.stats;
+    for(const SearchResult& helperResult : helperResults) {
+        stats.nodes += helperResult.stats.nodes;
+        stats.qnodes += helperResult.stats.qnodes;
+        if(helperResult.bestMove.has_value() && helperResult.stats.depth > result.stats.depth) {
+            result.bestMove = helperResult.bestMove;
+            result.eval = helperResult.eval;
+            stats.depth = helperResult.stats.depth;
+        }
+    }
+    stats.hashfull = tt_->hashfull();
+    result.stats = stats;
+    return result;
+}
+
+SearchResult Engine::iterate_(Game& game, const SearchLimits& limits, int startDepth) {
     // reset stats counter once at root
     stats_.clear();
+    startClock_(game, limits);
+
+    MoveList moves;
+    game.generateLegalMoves(moves);
+
+    // if we don't have a legal move, we're done; return nullopt
+    if (moves.size == 0) {
+        if (game.inCheck()) {
+            return SearchResult{std::nullopt, -Eval::CHECKMATE, stats_};
+        }
+
+        // not in check; stalemate
+        return SearchResult{std::nullopt, Eval::STALEMATE, stats_};
+    }
+
+    // the first iteration tries the best move of an earlier search first, every later one the previous iteration's
+    TTData ttData;
+    Move previousBest = tt_->probe(game.hash(), ttData) ? ttData.move : Move{};
+
+    SearchResult result;
+    const int maxDepth = std::clamp(limits.depth.value_or(MAX_DEPTH), 1, MAX_DEPTH);
+    for(int depth = std::min(startDepth, maxDepth); depth <= maxDepth; depth++) {
+        // Aspiration windows: the score rarely moves far between iterations, and a narrow window cuts off more. If the
+        // score lands outside, widen the side it failed on and search again.
+        int delta = ASPIRATION_WINDOW;
+        int alpha = -Eval::CHECKMATE;
+        int beta = Eval::CHECKMATE;
+        if(depth >= ASPIRATION_MIN_DEPTH && stats_.depth > 0 && !Eval::isMate(result.eval)) {
+            alpha = std::max(result.eval - delta, -Eval::CHECKMATE);
+            beta = std::min(result.eval + delta, Eval::CHECKMATE);
+        }
+
+        int score = 0;
+        Move move{};
+        while(true) {
+            move = searchRoot_(game, moves, depth, previousBest, alpha, beta, score);
+            if(stopped_) {
+                break;
+            }
+            if(score <= alpha && alpha > -Eval::CHECKMATE) {
+                alpha = std::max(alpha - delta, -Eval::CHECKMATE);
+            } else if(score >= beta && beta < Eval::CHECKMATE) {
+                beta = std::min(beta + delta, Eval::CHECKMATE);
+                // the move that failed high is the one to try first again
+                previousBest = move;
+            } else {
+                break;
+            }
+            delta *= 2;
+        }
+
+        // a stopped iteration has not searched every move, so its result cannot be trusted
+        if(stopped_) {
+            break;
+        }
+        result.bestMove = move;
+        result.eval = score;
+        stats_.depth = depth;
+        previousBest = move;
+
+        // a mate within the searched depth is exact; deeper iterations cannot change it
+        if(Eval::isMate(score) && Eval::CHECKMATE - abs(score) <= depth) {
+            break;
+        }
+        if(std::chrono::steady_clock::now() >= softDeadline_) {
+            break;
+        }
+    }
+
+    result.stats = stats_;
+    return result;
+}
+
+SearchResult Engine::search(Game& game, int depth) {
+    SearchLimits limits;
+    limits.depth = depth;
+    return search(game, limits);
+}
+
+void Engine::setThreads(int numThreads) {
+    helpers_.clear();
+    for(int thread = 1; thread < numThreads; thread++) {
+        helpers_.push_back(std::unique_ptr<Engine>(new Engine(tt_, &stopHelpers_))); // NOLINT(cppcoreguidelines-owning-memory) the constructor is private to make_unique
+    }
+}
+
+void Engine::startClock_(const Game& game, const SearchLimits& limits) {
+    using std::chrono::milliseconds;
+    const auto now = std::chrono::steady_clock::now();
+    softDeadline_ = std::chrono::steady_clock::time_point::max();
+    hardDeadline_ = std::chrono::steady_clock::time_point::max();
+    maxNodes_ = limits.nodes.value_or(UINT64_MAX);
+    stopped_ = false;
+
+    // An iteration usually takes longer than all earlier ones together, so one started after half the time would
+    // rarely finish before the hard deadline
+    if(limits.moveTime.has_value()) {
+        softDeadline_ = now + *limits.moveTime / 2;
+        hardDeadline_ = now + *limits.moveTime;
+    }
+
+    // Spend an even share of the clock, as if the game had MOVES_TO_GO more moves, plus most of the increment. The hard
+    // deadline allows finishing a late iteration, but never uses up the clock.
+    const bool isWhite = game.sideToMove() == Color::White;
+    const std::optional<milliseconds> timeLeft = isWhite ? limits.whiteTime : limits.blackTime;
+    if(timeLeft.has_value()) {
+        constexpr int MOVES_TO_GO = 30;
+        constexpr int HARD_LIMIT_FACTOR = 3;
+        // kept back for the time spent outside the search, e.g., by the GUI
+        constexpr milliseconds MOVE_OVERHEAD{30};
+        const milliseconds increment = isWhite ? limits.whiteIncrement : limits.blackIncrement;
+        const milliseconds available = std::max(milliseconds{1}, *timeLeft - MOVE_OVERHEAD);
+        const milliseconds target = std::min(available, *timeLeft / MOVES_TO_GO + increment * 3 / 4); // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers) most of the increment
+        softDeadline_ = std::min(softDeadline_, now + target / 2);
+        hardDeadline_ = std::min(hardDeadline_, now + std::min(available, target * HARD_LIMIT_FACTOR));
+    }
+}
+
+bool Engine::shouldStop_() noexcept {
+    // the main search always completes depth 1, so there is a move to return; helpers have no such duty and stop as
+    // soon as they are signalled, even in their first iteration
+    if(stopped_ || (stopSignal_ == nullptr && stats_.depth == 0)) {
+        return stopped_;
+    }
+    const uint64_t searched = stats_.nodes + stats_.qnodes;
+    stopped_ = searched >= maxNodes_
+        || ((searched & (TIME_CHECK_INTERVAL - 1)) == 0
+            && ((stopSignal_ != nullptr && stopSignal_->load(std::memory_order_relaxed)) || std::chrono::steady_clock::now() >= hardDeadline_));
+    return stopped_;
+}
 
+Move Engine::searchRoot_(Game& game, const MoveList& moves, int depth, const Move previousBest, int alpha, const int beta, int& bestScore) {
+    const int originalAlpha = alpha;
     Move bestMove{};  // NOTE: this starts as a junk move
+    StateInfo saved;
 
-    bool legalMoveExists = false;
-    MoveList moves;
-    game.generatePseudoLegalMoves(moves);
-    
     // order moves to greatly improve alpha-beta pruning
     std::array<int, MoveList::kMaxMoves> indices{};
-    orderMoves(game, moves, indices);
+    orderMoves(game, moves, indices, previousBest);
 
     // start with the worst possible move
-    int bestScore = -Eval::CHECKMATE;
+    bestScore = -Eval::CHECKMATE;
     for (int moveIndex = 0; moveIndex < moves.size ; moveIndex++) {
         // make move from indices
         const Move move = moves.data[indices[moveIndex]];
-        const UndoInfo undoInfo = game.getUndoInfo(move);
     
-        game.makeMove(move);
-
-        // this move is not legal
-        if(game.doesMovePutUsInCheck(move)) {
-            game.undoMove(move, undoInfo);
-            continue;
+        game.makeMove(move, saved);
+        const int score = searchChild_(game, alpha, beta, depth, 0, moveIndex == 0);
+        game.unmakeMove(move, saved);
+        if(stopped_) {
+            return bestMove;
         }
 
-        // we have at least one legal move
-        legalMoveExists = true;
-
-        // init search with alpha = worst move, beta = best move
-        const int score = -alphaBeta_(game, -Eval::CHECKMATE, Eval::CHECKMATE, depth-1, 1);
         if (score > bestScore) {
             bestScore = score;
             bestMove = move;
         }
-
-        game.undoMove(move, undoInfo);
+        alpha = std::max(alpha, score);
+        if (score >= beta) {
+            break;
+        }
     }
 
-    // if we don't have a legal move, we're done; return nullopt
-    if (!legalMoveExists) {
-        if (game.isInCheck(game.sideToMove())) {
-            return SearchResult{std::nullopt, -Eval::CHECKMATE, stats_};
-        }
+    const Bound bound = bestScore >= beta ? Bound::Lower : (bestScore > originalAlpha ? Bound::Exact : Bound::Upper);
+    tt_->store(game.hash(), depth, Eval::scoreToTT(bestScore, 0), bound, bestMove);
+    return bestMove;
+}
 
-        // not in check; stalemate
-        return SearchResult{std::nullopt, Eval::STALEMATE, stats_};
+int Engine::searchChild_(Game& game, const int alpha, const int beta, const int depth, const int ply, const bool firstMove) { // NOLINT(misc-no-recursion)
+    // Principal variation search: with good ordering the first move is usually best, so search it with the full
+    // window, and only prove the others worse with a cheap null window. One that fails high beats alpha after all and
+    // is searched again with the full window for its exact score.
+    if(firstMove) {
+        return -alphaBeta_(game, -beta, -alpha, depth - 1, ply + 1);
     }
-
-    return SearchResult{bestMove, bestScore, stats_};
+    const int score = -alphaBeta_(game, -alpha - 1, -alpha, depth - 1, ply + 1);
+    if(score > alpha && score < beta && !stopped_) {
+        return -alphaBeta_(game, -beta, -alpha, depth - 1, ply + 1);
+    }
+    return score;
 }
 
-void Engine::orderMoves(Game& game, const MoveList& moves, std::array<int, MoveList::kMaxMoves>& indices) {
+void Engine::orderMoves(Game& game, const MoveList& moves, std::array<int, MoveList::kMaxMoves>& indices, const Move hashMove) {
     const int numMoves = moves.size;
 
     // return early if we don't have any moves
@@ -197,6 +386,12 @@ void Engine::orderMoves(Game& game, const MoveList& moves, std::array<int, MoveL
 
         int score = 0;
 
+        // The hash move was best in an earlier search of this position; try it before everything else
+        if(move == hashMove) {
+            constexpr int HASH_MOVE_BONUS = 1'000'000;
+            score += HASH_MOVE_BONUS;
+        }
+
         // Boost good captures
         if(move.isCapture()) {
             constexpr int CAPTURE_BONUS = 2000;
@@ -229,64 +424,123 @@ void Engine::orderMoves(Game& game, const MoveList& moves, std::array<int, MoveL
     }
 }
 
-int Engine::alphaBeta_(Game& game, int alpha, int beta, int depth, int ply) { // NOLINT(misc-no-recursion)
+int Engine::alphaBeta_(Game& game, int alpha, int beta, int depth, int ply, const bool allowNullMove) { // NOLINT(misc-no-recursion)
     stats_.nodes++;
+    if(shouldStop_()) {
+        return 0;
+    }
+    if(ply >= Eval::MAX_PLY - 1) {
+        return evaluatePosition(game);
+    }
 
     if (depth == 0) {
         return quiesce(game, alpha, beta, ply + 1);
     }
 
-    bool legalMoveExists = false;
+    const int originalAlpha = alpha;
+    Move hashMove{};
+    int ttScore = 0;
+    if(probeTT_(game, alpha, beta, depth, ply, hashMove, ttScore)) {
+        return ttScore;
+    }
+    StateInfo saved;
+
+    // Null move pruning: pass, letting the opponent move twice in a row. If a reduced search still fails high, some real
+    // move almost surely does too. Only tried in null window nodes whose static eval already beats beta, and never twice
+    // in a row. Zugzwang breaks the assumption that passing is worse than any move, so it is skipped when in check and
+    // when we have only king and pawns, where zugzwang is common.
+    if(allowNullMove && beta - alpha == 1 && depth >= NULL_MOVE_MIN_DEPTH && !game.inCheck() && !Eval::isMate(beta)
+        && game.hasNonPawnMaterial(game.sideToMove()) && evaluatePosition(game) >= beta) {
+        const int reduction = NULL_MOVE_REDUCTION + depth / NULL_MOVE_DEPTH_PER_REDUCTION;
+        const int nullDepth = std::max(0, depth - 1 - reduction);
+        game.makeNullMove(saved);
+        const int nullScore = -alphaBeta_(game, -beta, -beta + 1, nullDepth, ply + 1, false);
+        game.undoNullMove(saved);
+        if(stopped_) {
+            return 0;
+        }
+
+        if(nullScore >= beta) {
+            // a mate found after passing is not a real mate
+            const int score = Eval::isMate(nullScore) ? beta : nullScore;
+            if(depth < NULL_MOVE_VERIFICATION_DEPTH) {
+                return score;
+            }
+            // deep cutoffs prune the most, so verify them with a reduced search of our own moves, without null moves
+            const int verifiedScore = alphaBeta_(game, beta - 1, beta, nullDepth, ply, false);
+            if(stopped_) {
+                return 0;
+            }
+            if(verifiedScore >= beta) {
+                return score;
+            }
+        }
+    }
+
     MoveList moves;
-    game.generatePseudoLegalMoves(moves);
+    game.generateLegalMoves(moves);
+
+    // we don't have any legal moves in the position; return with checkmate / stalemate
+    if(moves.size == 0) {
+        // checkmate
+        if(game.inCheck()) {
+            // Move gets worse if ply is larger
+            return -Eval::CHECKMATE + ply;
+        }
+
+        // not in check; return stalemate
+        return Eval::STALEMATE;
+    }
 
     // order moves to greatly improve alpha-beta pruning
     std::array<int, MoveList::kMaxMoves> indices{};
-    orderMoves(game, moves, indices);
+    orderMoves(game, moves, indices, hashMove);
 
+    Move bestMove{};
     for (int moveIndex = 0; moveIndex < moves.size; moveIndex++)  {
         // make move from indices
         const Move move = moves.data[indices[moveIndex]];
-        const UndoInfo undoInfo = game.getUndoInfo(move);
 
-        game.makeMove(move);
+        game.makeMove(move, saved);
 
-        // this move is not legal
-        if(game.doesMovePutUsInCheck(move)) {
-            game.undoMove(move, undoInfo);
-            continue;
+        const int score = searchChild_(game, alpha, beta, depth, ply, moveIndex == 0);
+        game.unmakeMove(move, saved);
+        if(stopped_) {
+            return 0;
         }
 
-        // we have at least one legal move
-        legalMoveExists = true;
-
-        const int score = -alphaBeta_(game, -beta, -alpha, depth-1, ply + 1);
-        game.undoMove(move, undoInfo);
-
         if(score > alpha) {
             alpha = score;
+            bestMove = move;
         }
         
         if( score >= beta ) {
+            tt_->store(game.hash(), depth, Eval::scoreToTT(alpha, ply), Bound::Lower, move);
             return alpha;  // fail soft
         }
 
     }
 
-    // we don't have any legal moves in the position; return with checkmate / stalemate
-    // we put this after the loop so we can generate pseudo legal moves at first, which is faster
-    if(!legalMoveExists) {
-        // checkmate
-        if(game.isInCheck(game.sideToMove())) {
-            // Move gets worse if ply is larger
-            return -Eval::CHECKMATE + ply;
-        }
+    tt_->store(game.hash(), depth, Eval::scoreToTT(alpha, ply), alpha > originalAlpha ? Bound::Exact : Bound::Upper, bestMove);
+    return alpha;
+}
 
-        // not in check; return stalemate
-        return Eval::STALEMATE;
+bool Engine::probeTT_(const Game& game, int alpha, int beta, int depth, int ply, Move& hashMove, int& score) const noexcept {
+    TTData ttData;
+    if(!tt_->probe(game.hash(), ttData)) {
+        return false;
     }
+    hashMove = ttData.move;
 
-    return alpha;
+    // a stored result from a search at least as deep answers this one if its bound settles the window. PV nodes never
+    // cut: the stored result came from another window, and returning it would end the principal variation here.
+    if(ttData.depth < depth || beta - alpha > 1) {
+        return false;
+    }
+    score = Eval::scoreFromTT(ttData.score, ply);
+    return ttData.bound == Bound::Exact
+        || (ttData.bound == Bound::Lower && score >= beta)
+        || (ttData.bound == Bound::Upper && score <= alpha);
 }
 
 // TODO: incrementally update material in Game
@@ -1,15 +1,25 @@
 #pragma once
 
 #include "../game/Game.hpp"
+#include "TranspositionTable.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <optional>
+#include <vector>
 
 struct SearchStats {
     uint64_t nodes = 0;       // main search nodes
     uint64_t qnodes = 0;      // quiescence nodes
+    int hashfull = 0;         // permille of the transposition table written by this search
+    int depth = 0;            // deepest completed iteration
     // Clear the stats
     constexpr void clear() noexcept {
         nodes = 0;
         qnodes = 0;
+        hashfull = 0;
+        depth = 0;
     }
 } __attribute__((aligned(16))); // NOLINT[magic numbers] align to 16 bytes
 
@@ -95,17 +105,34 @@ namespace Eval {
     // TODO: is a number different than the arbitrary 2^20 better?
     static constexpr int CHECKMATE = 1'048'576;
     static constexpr int STALEMATE = 0;
+    static_assert(CHECKMATE <= TranspositionTable::MAX_SCORE, "mate scores must fit a transposition table entry");
+    // Deepest ply the search recurses to, quiescence included. Mate scores are at least CHECKMATE - MAX_PLY.
+    static constexpr int MAX_PLY = 256;
     
     // If the evaluation shows there will be a mate.
     constexpr bool isMate(const int eval) noexcept {
-        // we assume MAX_PLY (or max depth we recurse) is 256
-        constexpr int MAX_PLY = 256;
         return abs(eval) >= CHECKMATE - MAX_PLY;
     }
 
+    // Mate scores count plies from the root, but a transposition table entry may be reached at any ply. Stored, they
+    // count plies from the entry's own position instead.
+    constexpr int scoreToTT(const int eval, const int ply) noexcept {
+        if(!isMate(eval)) {
+            return eval;
+        }
+        return eval > 0 ? eval + ply : eval - ply;
+    }
+
+    // Convert a stored mate score back to count plies from the root.
+    constexpr int scoreFromTT(const int eval, const int ply) noexcept {
+        if(!isMate(eval)) {
+            return eval;
+        }
+        return eval > 0 ? eval - ply : eval + ply;
+    }
+
 
     inline std::string evalToString(const int eval, const Color color) noexcept {
-        // we assume MAX_PLY (or max depth we recurse) is 256
         if(isMate(eval)) {
             const int pliesToMate = CHECKMATE - abs(eval);
             // round plies to full moves
@@ -129,20 +156,55 @@ struct SearchResult {
     SearchStats stats;
 } __attribute__((aligned(32))); // NOLINT[magic numbers] align to 16 bytes
 
+// Limits a search stops at, whichever comes first. Unset limits do not apply; with none set, the search runs to
+// Engine::MAX_DEPTH. Clock times follow UCI: the time left on each side's clock and its increment per move. With more
+// than one thread, depth caps every thread, while nodes counts the main thread's search only.
+struct SearchLimits {
+    std::optional<int> depth;
+    std::optional<uint64_t> nodes;
+    std::optional<std::chrono::milliseconds> moveTime;
+    std::optional<std::chrono::milliseconds> whiteTime;
+    std::optional<std::chrono::milliseconds> blackTime;
+    std::chrono::milliseconds whiteIncrement{0};
+    std::chrono::milliseconds blackIncrement{0};
+};
+
+// Searches positions for the best move. With more than one thread, searches with Lazy SMP: helper threads search the
+// same position on copies of the game, sharing the transposition table, and the deepest completed result is played.
+// The helpers mostly fill the table with results the main thread then reuses.
+// See https://www.chessprogramming.org/Lazy_SMP
 class Engine {
 public:
-    constexpr Engine() noexcept = default;
+    // Deepest iteration a search starts.
+    static constexpr int MAX_DEPTH = 64;
+    // Time bestMove thinks for.
+    static constexpr std::chrono::milliseconds DEFAULT_MOVE_TIME{1000};
+
+    // Create a single threaded engine with a transposition table of about hashMegabytes.
+    explicit Engine(size_t hashMegabytes = TranspositionTable::DEFAULT_MEGABYTES)
+        : tt_{std::make_shared<TranspositionTable>(hashMegabytes)} {}
+    // Resize the transposition table to about hashMegabytes, emptying it.
+    void resizeHash(size_t hashMegabytes) { tt_->resize(hashMegabytes); }
+    // Empty the transposition table, e.g., for a new game.
+    void clearHash() noexcept { tt_->clear(); }
+    // Search on numThreads threads from the next search on; at least 1.
+    void setThreads(int numThreads);
+    // Number of threads a search uses.
+    int threads() const noexcept { return static_cast<int>(helpers_.size()) + 1; }
     // TODO: this should be const Game& game once we fix game move gen being non-const
-    // Get the best move in the current position.
+    // Get the best move in the current position, thinking for DEFAULT_MOVE_TIME.
     SearchResult bestMove(Game& game);
     // Evaluate the current position.
     int evaluatePosition(Game& game) const;
-    // Search for moves in the current position.
+    // Search the current position with iterative deepening until a limit is hit. Returns the result of the last
+    // completed iteration; depth 1 always completes, so there is a move whenever one is legal.
+    SearchResult search(Game& game, const SearchLimits& limits);
+    // Search the current position to exactly depth.
     SearchResult search(Game& game, int depth);
     // Search a bit more to ensure we end on a quiet move.
     int quiesce(Game& game, int alpha, int beta, int ply);
-    // Order moves to improve Alpha Beta pruning.
-    void orderMoves(Game& game, const MoveList& moves, std::array<int, MoveList::kMaxMoves>& indices);
+    // Order moves to improve Alpha Beta pruning. The hash move, if it is one of the moves, goes first.
+    void orderMoves(Game& game, const MoveList& moves, std::array<int, MoveList::kMaxMoves>& indices, Move hashMove = Move{});
 
     // Get piece value from piece.
     static constexpr int pieceValueFromType(const Piece piece) {
@@ -163,8 +225,8 @@ public:
             return 0;
         }
 
-        const int victim = pieceValueFromType(game.mailbox()[move.targetSquare()]);
-        const int attacker = pieceValueFromType(game.mailbox()[move.sourceSquare()]);
+        const int victim = pieceValueFromType(game.pieceAt(move.targetSquare()));
+        const int attacker = pieceValueFromType(game.pieceAt(move.sourceSquare()));
     
         // scale to ensure captures rank above quiet moves
         constexpr int VICTIM_BONUS = 100;
@@ -172,17 +234,64 @@ public:
     }
 
 private:
+    // Create a helper engine that searches on table and stops once stopSignal is set.
+    Engine(std::shared_ptr<TranspositionTable> table, const std::atomic<bool>* stopSignal) : tt_{std::move(table)}, stopSignal_{stopSignal} {}
     // Evalute the current position's piece costs. E.g., 1 -> pawn, 3 -> bishop / knight, ... 
     int evaluatePieceSum_(Game& game, Color color) const;
     // Evaluate the current position's piece placements.
     int evaluatePiecePlacementBonus_(Game& game, Color color) const;
-    // internal negaMax alpha beta search that search() implements
-    int alphaBeta_(Game& game, int alpha, int beta, int depth, int ply);
+    // Iterative deepening from startDepth on this thread until a limit is hit.
+    SearchResult iterate_(Game& game, const SearchLimits& limits, int startDepth);
+    // Set the deadlines and node budget of a search starting now.
+    void startClock_(const Game& game, const SearchLimits& limits);
+    // Whether the search must stop. Cheap enough to call at every node: it reads the clock and the stop signal once
+    // every TIME_CHECK_INTERVAL nodes. Once true, it stays true until the next search.
+    bool shouldStop_() noexcept;
+    // Search every root move to depth within the alpha beta window, trying previousBest first. Writes the best score,
+    // fail soft, to bestScore and returns the best move; both are junk if the search was stopped.
+    Move searchRoot_(Game& game, const MoveList& moves, int depth, Move previousBest, int alpha, int beta, int& bestScore);
+    // Search the position after a move of the node at ply with depth left, with the node's alpha beta window if the
+    // move is its first and a null window otherwise; returns the score from the node's side.
+    int searchChild_(Game& game, int alpha, int beta, int depth, int ply, bool firstMove);
+    // internal negaMax alpha beta search that search() implements; allowNullMove is false right after a null move
+    int alphaBeta_(Game& game, int alpha, int beta, int depth, int ply, bool allowNullMove = true);
+    // Look the position up in the transposition table. Writes the stored move to hashMove; returns true and writes
+    // score if a stored result at least depth deep settles the alpha beta window of a null window (non-PV) node.
+    bool probeTT_(const Game& game, int alpha, int beta, int depth, int ply, Move& hashMove, int& score) const noexcept;
     // Get popcount for an integer
     static constexpr int popcount_(uint64_t n) {
         return __builtin_popcountll(n);
     }
 
+    // Half width of the first aspiration window around the previous iteration's score; doubles on every failure.
+    static constexpr int ASPIRATION_WINDOW = 25;
+    // Shallowest iteration searched with an aspiration window; shallower ones are cheap and their scores swing more.
+    static constexpr int ASPIRATION_MIN_DEPTH = 4;
+    // Shallowest depth null move pruning is tried at.
+    static constexpr int NULL_MOVE_MIN_DEPTH = 3;
+    // The null move is searched this many plies shallower, plus one more for every NULL_MOVE_DEPTH_PER_REDUCTION of
+    // depth, on top of the ply a normal move takes.
+    static constexpr int NULL_MOVE_REDUCTION = 3;
+    static constexpr int NULL_MOVE_DEPTH_PER_REDUCTION = 6;
+    // Shallowest depth a null move cutoff is verified at with a reduced search of our own moves.
+    static constexpr int NULL_MOVE_VERIFICATION_DEPTH = 8;
+    // Nodes between clock and stop signal reads; a power of two.
+    static constexpr uint64_t TIME_CHECK_INTERVAL = 2048;
+
     // Keep track of search stats (e.g., how many positions evaluated)
     SearchStats stats_;
+    // Limits of the current search. No new iteration starts after the soft deadline; the search stops mid iteration
+    // at the hard one.
+    std::chrono::steady_clock::time_point softDeadline_;
+    std::chrono::steady_clock::time_point hardDeadline_;
+    uint64_t maxNodes_{UINT64_MAX};
+    bool stopped_{false};
+    // Results of earlier searches, kept between searches and shared with the helpers
+    std::shared_ptr<TranspositionTable> tt_;
+    // Helper engines, one per extra thread; each has its own stats and search state
+    std::vector<std::unique_ptr<Engine>> helpers_;
+    // Set by the main engine once its search is done, to stop its helpers
+    std::atomic<bool> stopHelpers_{false};
+    // The main engine's stopHelpers_ if this is a helper, else nullptr
+    const std::atomic<bool>* stopSignal_{nullptr};
 };
\ No newline at end of file
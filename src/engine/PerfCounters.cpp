@@ -0,0 +1,137 @@
+#include "PerfCounters.hpp"
+
+#include <iomanip>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr std::array<const char*, PerfCounters::NUM_EVENTS> EVENT_NAMES{"cycles", "instructions", "L1D misses", "LLC misses", "branch misses"};
+
+#if defined(__linux__)
+    // Open one counter of the calling thread, counted in user space only, so it works without extra privileges.
+    int openCounter(uint32_t type, uint64_t config) noexcept {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // pid 0 and cpu -1 count this thread, and with inherit its future threads, on any CPU
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0)); // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-vararg) C API
+    }
+
+    int openEvent(PerfCounters::Event event) noexcept {
+        constexpr uint64_t CACHE_READ_MISS = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16); // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers) perf's cache config layout
+        switch(event) {
+            case PerfCounters::Event::Cycles: return openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+            case PerfCounters::Event::Instructions: return openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+            case PerfCounters::Event::L1DMisses: return openCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | CACHE_READ_MISS);
+            case PerfCounters::Event::LLCMisses: return openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+            case PerfCounters::Event::BranchMisses: return openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        }
+        return -1;
+    }
+#endif
+} // namespace
+
+PerfCounters::PerfCounters() noexcept {
+    fds_.fill(-1);
+#if defined(__linux__)
+    for(int event = 0; event < NUM_EVENTS; event++) {
+        fds_.at(event) = openEvent(static_cast<Event>(event));
+    }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#if defined(__linux__)
+    for(const int fd : fds_) { // NOLINT(readability-identifier-length)
+        if(fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+bool PerfCounters::available() const noexcept {
+    for(const int fd : fds_) { // NOLINT(readability-identifier-length)
+        if(fd >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerfCounters::start() noexcept {
+#if defined(__linux__)
+    for(const int fd : fds_) { // NOLINT(readability-identifier-length)
+        if(fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0); // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-vararg) C API
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0); // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-vararg) C API
+        }
+    }
+#endif
+}
+
+void PerfCounters::stop() noexcept {
+#if defined(__linux__)
+    for(int event = 0; event < NUM_EVENTS; event++) {
+        const int fd = fds_.at(event); // NOLINT(readability-identifier-length)
+        values_.at(event) = 0;
+        if(fd < 0) {
+            continue;
+        }
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0); // NOLINT(cppcoreguidelines-pro-type-vararg, hicpp-vararg) C API
+
+        // value, time enabled, time running
+        std::array<uint64_t, 3> data{};
+        if(read(fd, data.data(), sizeof(data)) != static_cast<ssize_t>(sizeof(data))) {
+            continue;
+        }
+        const auto [count, enabled, running] = data;
+        // with more counters than the CPU has, the kernel takes turns; extrapolate to the whole time
+        values_.at(event) = running > 0 && running < enabled ? static_cast<uint64_t>(static_cast<double>(count) * static_cast<double>(enabled) / static_cast<double>(running)) : count;
+    }
+#endif
+}
+
+std::optional<uint64_t> PerfCounters::value(Event event) const noexcept {
+    const auto index = static_cast<size_t>(event);
+    if(fds_.at(index) < 0) {
+        return std::nullopt;
+    }
+    return values_.at(index);
+}
+
+void PerfCounters::printPerNode(std::ostream& out, uint64_t nodes) const {
+    if(!available()) {
+        out << "Hardware counters unavailable\n";
+        return;
+    }
+
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(2);
+    for(int event = 0; event < NUM_EVENTS; event++) {
+        const std::optional<uint64_t> count = value(static_cast<Event>(event));
+        if(count.has_value() && nodes > 0) {
+            out << EVENT_NAMES.at(event) << "/node: " << static_cast<double>(*count) / static_cast<double>(nodes) << "  ";
+        }
+    }
+    const std::optional<uint64_t> cycles = value(Event::Cycles);
+    const std::optional<uint64_t> instructions = value(Event::Instructions);
+    if(cycles.has_value() && instructions.has_value() && *cycles > 0) {
+        out << "IPC: " << static_cast<double>(*instructions) / static_cast<double>(*cycles);
+    }
+    out << "\n";
+    out.flags(flags);
+    out.precision(precision);
+}
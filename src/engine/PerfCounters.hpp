@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+
+// Hardware performance counters, read through Linux's perf_event_open, to tell why a benchmark got faster or slower.
+// Counts the constructing thread and every thread it starts while counting. A counter the kernel, CPU, or permissions
+// do not allow is skipped; on other platforms none are available, and the benchmarks carry on without them.
+class PerfCounters {
+public:
+    enum class Event : uint8_t {
+        Cycles,
+        Instructions,
+        L1DMisses,
+        LLCMisses,
+        BranchMisses
+    };
+    static constexpr int NUM_EVENTS = 5;
+
+    // Open every counter that is available; they start stopped.
+    PerfCounters() noexcept;
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    PerfCounters(PerfCounters&&) = delete;
+    PerfCounters& operator=(PerfCounters&&) = delete;
+
+    // If at least one counter could be opened.
+    bool available() const noexcept;
+    // Zero and start every counter.
+    void start() noexcept;
+    // Stop every counter and read its value.
+    void stop() noexcept;
+    // Value read by the last stop, scaled up if the kernel had to share the hardware counter; nullopt if unavailable.
+    std::optional<uint64_t> value(Event event) const noexcept;
+    // Print every available counter per node, and the instructions per cycle, on one line.
+    void printPerNode(std::ostream& out, uint64_t nodes) const;
+
+private:
+    // File descriptor of each counter; -1 if unavailable.
+    std::array<int, NUM_EVENTS> fds_{};
+    std::array<uint64_t, NUM_EVENTS> values_{};
+};
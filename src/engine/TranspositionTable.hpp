@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "../game/Move.hpp"
+
+// What a stored score says about the position's true score.
+enum class Bound : uint8_t {
+    None,   // empty entry
+    Upper,  // failed low; the true score is at most the score
+    Lower,  // failed high; the true score is at least the score
+    Exact
+};
+
+// A transposition table entry as read by probe.
+struct TTData {
+    // Best or refuting move found; may be junk after a key collision, so it must be checked against the legal moves.
+    Move move;
+    int score{0};
+    int depth{0};
+    Bound bound{Bound::None};
+};
+
+// Caches search results by Zobrist key, so transpositions and re-searches reuse earlier work.
+//
+// Each 64 byte bucket fills one cache line with 4 entries; a probe touches a single line. An entry packs the move, the
+// score, the depth, the bound, and the search generation that wrote it into one data word. A new entry replaces the
+// bucket's least valuable one: shallow entries from old searches go first.
+// See https://www.chessprogramming.org/Transposition_Table
+//
+// Lock-free, so search threads may share one table, in the same way as PerftTable: each entry is the data word and the
+// key XOR the data, and a torn write from two racing threads reads as a miss.
+class TranspositionTable {
+public:
+    // Size used when none is given.
+    static constexpr size_t DEFAULT_MEGABYTES = 16;
+    // Largest score magnitude an entry holds; scores are stored in 24 bits.
+    static constexpr int MAX_SCORE = (1 << 23) - 1;
+
+    // Allocate a table of about the given size, rounded down to a power of two buckets. Entries start empty.
+    explicit TranspositionTable(size_t megabytes = DEFAULT_MEGABYTES) { resize(megabytes); }
+
+    // Reallocate the table to about the given size; every entry is lost.
+    void resize(size_t megabytes) {
+        constexpr size_t BYTES_PER_MEGABYTE = 1024 * 1024;
+        const size_t maxBuckets = std::max<size_t>(1, megabytes * BYTES_PER_MEGABYTE / sizeof(Bucket_));
+        size_t numBuckets = 1;
+        while(numBuckets * 2 <= maxBuckets) {
+            numBuckets *= 2;
+        }
+        // Align to a huge page and ask Linux to back the table with huge pages: probes land all over the table, and with
+        // 4 KB pages nearly every one of them also misses the TLB
+        const size_t bytes = numBuckets * sizeof(Bucket_);
+        void* memory = ::operator new(bytes, std::align_val_t{HUGE_PAGE_BYTES});
+#if defined(__linux__)
+        madvise(memory, bytes, MADV_HUGEPAGE);
+#endif
+        buckets_.reset(static_cast<Bucket_*>(memory));
+        std::uninitialized_value_construct_n(buckets_.get(), numBuckets);
+        mask_ = numBuckets - 1;
+        generation_ = 0;
+    }
+
+    // Empty every entry. Not safe while other threads use the table.
+    void clear() noexcept {
+        for(size_t i = 0; i <= mask_; i++) {
+            for(Entry_& entry : buckets_[i].entries) {
+                entry.data.store(0, std::memory_order_relaxed);
+                entry.check.store(0, std::memory_order_relaxed);
+            }
+        }
+        generation_ = 0;
+    }
+
+    // Start a new search; entries from earlier searches become the first to be replaced. Not safe while other threads
+    // use the table.
+    void newSearch() noexcept { generation_ = (generation_ + 1) & GENERATION_MASK; }
+
+    // If the position with key is stored, write its entry to data.
+    bool probe(uint64_t key, TTData& data) const noexcept {
+        const Bucket_& bucket = buckets_[key & mask_];
+        for(const Entry_& entry : bucket.entries) {
+            const uint64_t word = entry.data.load(std::memory_order_relaxed);
+            const uint64_t check = entry.check.load(std::memory_order_relaxed);
+            if((check ^ word) == key && boundOf_(word) != Bound::None) {
+                data.move = moveOf_(word);
+                data.score = scoreOf_(word);
+                data.depth = depthOf_(word);
+                data.bound = boundOf_(word);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Store a search result for the position with key, searched to depth. Mate scores must count plies from the
+    // position, not from the root; see Eval::scoreToTT.
+    void store(uint64_t key, int depth, int score, Bound bound, Move move) noexcept {
+        Bucket_& bucket = buckets_[key & mask_];
+
+        // Overwrite the position's own entry if it has one, else the entry worth the least: shallow and old
+        Entry_* target = &bucket.entries[0];
+        uint64_t targetWord = target->data.load(std::memory_order_relaxed);
+        bool sameKey = false;
+        for(Entry_& entry : bucket.entries) {
+            const uint64_t word = entry.data.load(std::memory_order_relaxed);
+            sameKey = (entry.check.load(std::memory_order_relaxed) ^ word) == key;
+            if(sameKey || boundOf_(word) == Bound::None) {
+                target = &entry;
+                targetWord = word;
+                break;
+            }
+            if(worth_(word) < worth_(targetWord)) {
+                target = &entry;
+                targetWord = word;
+            }
+        }
+
+        // A result without a move (e.g., a fail low) keeps the move an earlier search of the same position found
+        const bool keepMove = sameKey && boundOf_(targetWord) != Bound::None && move == Move{};
+        const uint64_t word = pack_(keepMove ? moveOf_(targetWord) : move, depth, bound, score);
+        target->data.store(word, std::memory_order_relaxed);
+        target->check.store(key ^ word, std::memory_order_relaxed);
+    }
+
+    // Permille of the table written by the current search, estimated from the first buckets.
+    int hashfull() const noexcept {
+        constexpr size_t SAMPLE_BUCKETS = 200;
+        constexpr int PERMILLE = 1000;
+        const size_t sampled = std::min(SAMPLE_BUCKETS, mask_ + 1);
+        int used = 0;
+        for(size_t i = 0; i < sampled; i++) {
+            for(const Entry_& entry : buckets_[i].entries) {
+                const uint64_t word = entry.data.load(std::memory_order_relaxed);
+                used += static_cast<int>(boundOf_(word) != Bound::None && generationOf_(word) == generation_);
+            }
+        }
+        return used * PERMILLE / static_cast<int>(sampled * ENTRIES_PER_BUCKET);
+    }
+
+private:
+    // Data word layout, from the low bits: the move's source, target, flag, and promotion, the depth, the bound, the
+    // generation, and the signed score in the top bits.
+    static constexpr int SOURCE_SHIFT = 0;
+    static constexpr int TARGET_SHIFT = 6;
+    static constexpr int FLAG_SHIFT = 12;
+    static constexpr int PROMOTION_SHIFT = 16;
+    static constexpr int DEPTH_SHIFT = 20;
+    static constexpr int BOUND_SHIFT = 28;
+    static constexpr int GENERATION_SHIFT = 30;
+    static constexpr int SCORE_SHIFT = 40;
+    static constexpr uint64_t SQUARE_MASK = 0x3F;
+    static constexpr uint64_t FLAG_MASK = 0xF;
+    static constexpr uint64_t PROMOTION_MASK = 0x7;
+    static constexpr uint64_t DEPTH_MASK = 0xFF;
+    static constexpr uint64_t BOUND_MASK = 0x3;
+    static constexpr uint8_t GENERATION_MASK = 0x3F;
+    // Cost, in depth, of every generation an entry is old when picking one to replace.
+    static constexpr int AGE_WEIGHT = 8;
+    static constexpr int ENTRIES_PER_BUCKET = 4;
+    static constexpr size_t HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+
+    struct Entry_ {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> data{0};
+    };
+    // 4 entries of 16 bytes fill a cache line.
+    struct alignas(64) Bucket_ { // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers) cache line size
+        std::array<Entry_, ENTRIES_PER_BUCKET> entries{};
+    };
+    static_assert(sizeof(Bucket_) == 64, "a bucket must fill exactly one cache line"); // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+    static_assert(std::is_trivially_destructible_v<Bucket_>, "buckets are freed without running destructors");
+
+    uint64_t pack_(Move move, int depth, Bound bound, int score) const noexcept {
+        return (static_cast<uint64_t>(move.sourceSquare()) << SOURCE_SHIFT)
+            | (static_cast<uint64_t>(move.targetSquare()) << TARGET_SHIFT)
+            | (static_cast<uint64_t>(move.flag()) << FLAG_SHIFT)
+            | (static_cast<uint64_t>(move.promotion()) << PROMOTION_SHIFT)
+            | (static_cast<uint64_t>(std::clamp(depth, 0, UINT8_MAX)) << DEPTH_SHIFT)
+            | (static_cast<uint64_t>(bound) << BOUND_SHIFT)
+            | (static_cast<uint64_t>(generation_) << GENERATION_SHIFT)
+            | (static_cast<uint64_t>(score) << SCORE_SHIFT);
+    }
+    static constexpr Move moveOf_(uint64_t word) noexcept {
+        return Move{static_cast<int>((word >> SOURCE_SHIFT) & SQUARE_MASK), static_cast<int>((word >> TARGET_SHIFT) & SQUARE_MASK),
+            static_cast<MoveFlag>((word >> FLAG_SHIFT) & FLAG_MASK), static_cast<Promotion>((word >> PROMOTION_SHIFT) & PROMOTION_MASK)};
+    }
+    static constexpr int depthOf_(uint64_t word) noexcept { return static_cast<int>((word >> DEPTH_SHIFT) & DEPTH_MASK); }
+    static constexpr Bound boundOf_(uint64_t word) noexcept { return static_cast<Bound>((word >> BOUND_SHIFT) & BOUND_MASK); }
+    static constexpr uint8_t generationOf_(uint64_t word) noexcept { return static_cast<uint8_t>((word >> GENERATION_SHIFT) & GENERATION_MASK); }
+    // The arithmetic shift sign extends the score.
+    static constexpr int scoreOf_(uint64_t word) noexcept { return static_cast<int>(static_cast<int64_t>(word) >> SCORE_SHIFT); }
+
+    // How much an entry is worth keeping; deep entries from the current search are worth the most.
+    int worth_(uint64_t word) const noexcept {
+        const int age = (generation_ - generationOf_(word)) & GENERATION_MASK;
+        return depthOf_(word) - AGE_WEIGHT * age;
+    }
+
+    // Frees the huge page aligned allocation; buckets are trivially destructible.
+    struct HugePageDeleter_ {
+        void operator()(Bucket_* buckets) const noexcept { ::operator delete(buckets, std::align_val_t{HUGE_PAGE_BYTES}); }
+    };
+
+    std::unique_ptr<Bucket_[], HugePageDeleter_> buckets_; // NOLINT(cppcoreguidelines-avoid-c-arrays, modernize-avoid-c-arrays) owns a raw aligned allocation
+    size_t mask_{0};
+    uint8_t generation_{0};
+};
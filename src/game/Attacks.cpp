@@ -0,0 +1,265 @@
+#include "Attacks.hpp"
+
+#include <cstdlib>
+#include <string_view>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables) tables are built once at startup and read-only afterwards
+Attacks::SliderBackend Attacks::sliderBackend = Attacks::SliderBackend::Magic;
+Attacks::SliderAttacks Attacks::rookAttacksFn = Attacks::tableRookAttacks<Attacks::SliderBackend::Magic>;
+Attacks::SliderAttacks Attacks::bishopAttacksFn = Attacks::tableBishopAttacks<Attacks::SliderBackend::Magic>;
+std::array<Attacks::Magic, Utils::NUM_SQUARES> Attacks::rookMagics{};
+std::array<Attacks::Magic, Utils::NUM_SQUARES> Attacks::bishopMagics{};
+
+namespace {
+    // Attack sets for every square and relevant occupancy; each square owns a slice of 2^(mask bits) entries.
+    std::array<Bitboard, Attacks::ROOK_TABLE_SIZE> rookAttackTable{};
+    std::array<Bitboard, Attacks::BISHOP_TABLE_SIZE> bishopAttackTable{};
+
+    // Rays from every square for the Portable backend, indexed [direction][square]; rook directions first, then bishop.
+    constexpr int NUM_ROOK_DIRECTIONS = 4;
+    constexpr int NUM_DIRECTIONS = 8;
+    std::array<std::array<Bitboard, Utils::NUM_SQUARES>, NUM_DIRECTIONS> rays{};
+    // NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+
+    // Magic numbers for this project's square layout (a8 = 0, h1 = 63), found offline with a sparse random search.
+    // NOLINTBEGIN(readability-magic-numbers, cppcoreguidelines-avoid-magic-numbers)
+    constexpr std::array<uint64_t, Utils::NUM_SQUARES> ROOK_MAGIC_NUMBERS {
+        0x1080004008801020ULL, 0x0840092002c03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+        0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+        0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+        0x000a001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+        0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021d00100ULL,
+        0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000a0001768104ULL,
+        0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+        0x0442000a00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040a00128541ULL,
+        0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+        0x0400802402800800ULL, 0xc100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+        0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000a0020ULL,
+        0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+        0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040a00300ULL, 0x0801100280080480ULL,
+        0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+        0x0000209300488001ULL, 0x04c1002414824001ULL, 0x020020000b001041ULL, 0x7000100004200901ULL,
+        0x8002002004100802ULL, 0x30010002084c0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL,
+    };
+
+    constexpr std::array<uint64_t, Utils::NUM_SQUARES> BISHOP_MAGIC_NUMBERS {
+        0xa010041108003100ULL, 0x006082020a002900ULL, 0x6810010619200000ULL, 0x08281a0520000408ULL,
+        0x0001104001000400ULL, 0x0018901008048400ULL, 0x00040a0210245280ULL, 0x000200210808a402ULL,
+        0x9140048410821200ULL, 0x0800091010820041ULL, 0x20504804832202c0ULL, 0x0100091401081000ULL,
+        0x8021011140000012ULL, 0x0810020804450400ULL, 0x208b0542109008a2ULL, 0x0080084a08040204ULL,
+        0x0040e2a80811244cULL, 0x2505022008008108ULL, 0x0430220100420040ULL, 0x010a040420220040ULL,
+        0x1105000290400000ULL, 0x0093001200822120ULL, 0x4000a62048043004ULL, 0x280120048a015004ULL,
+        0x006090002a020814ULL, 0x44042000240800d0ULL, 0x01102800040a4400ULL, 0x1004080080220040ULL,
+        0x0001001011004024ULL, 0x0010044000805040ULL, 0x0914041200820100ULL, 0x0004821012821480ULL,
+        0x0024040500c05021ULL, 0x0088611002080200ULL, 0x0116080a00040020ULL, 0x4000020080080080ULL,
+        0x2450450140840040ULL, 0x0000880201484100ULL, 0x0222020404020092ULL, 0x8081110600002e00ULL,
+        0x2842101105000801ULL, 0x1100809008001025ULL, 0x00020202221c0400ULL, 0x0422014022009020ULL,
+        0x0210046102100c00ULL, 0xc004008082029102ULL, 0x00aa461801101200ULL, 0x0404080080201108ULL,
+        0x020542108c205002ULL, 0x0410544804100100ULL, 0x0040910841100000ULL, 0x0400200042021100ULL,
+        0x00004204850400c0ULL, 0x0200100410a42102ULL, 0x1040020801210102ULL, 0x0805040410420000ULL,
+        0x2884804130100200ULL, 0x800c262201242000ULL, 0x1058000194108800ULL, 0x0014221054420204ULL,
+        0x0104000012a02200ULL, 0x0200881003300100ULL, 0x0140400202840100ULL, 0x0402020801010201ULL,
+    };
+    // NOLINTEND(readability-magic-numbers, cppcoreguidelines-avoid-magic-numbers)
+
+    // Walk every ray from square, stopping at (and including) the first occupied square. Slow; only used to build tables.
+    template<std::size_t N>
+    Bitboard slidingAttacks(int square, Bitboard occupancy, const std::array<std::array<int, 2>, N>& deltas) {
+        Bitboard attacks{0};
+        for (const auto delta : deltas) {
+            int curCol = Utils::getCol(square) + delta[0];
+            int curRow = Utils::getRow(square) + delta[1];
+            while (Utils::onBoard(curCol, curRow)) {
+                const int curSquare = Utils::getSquareIndex(curCol, curRow);
+                attacks.setSquare(curSquare);
+                if (occupancy.containsSquare(curSquare)) {
+                    break;
+                }
+                curCol += delta[0];
+                curRow += delta[1];
+            }
+        }
+        return attacks;
+    }
+
+    // Relevant occupancy mask; each ray without its last square, since a piece on the edge can not block anything behind it.
+    template<std::size_t N>
+    Bitboard relevantMask(int square, const std::array<std::array<int, 2>, N>& deltas) {
+        Bitboard mask{0};
+        for (const auto delta : deltas) {
+            int curCol = Utils::getCol(square) + delta[0];
+            int curRow = Utils::getRow(square) + delta[1];
+            while (Utils::onBoard(curCol + delta[0], curRow + delta[1])) {
+                mask.setSquare(Utils::getSquareIndex(curCol, curRow));
+                curCol += delta[0];
+                curRow += delta[1];
+            }
+        }
+        return mask;
+    }
+
+    // Fill magics and their attack table for one slider type, laid out for a table backend.
+    template<Attacks::SliderBackend Backend, std::size_t N, std::size_t TableSize>
+    void initMagics(std::array<Attacks::Magic, Utils::NUM_SQUARES>& magics,
+                    std::array<Bitboard, TableSize>& table,
+                    const std::array<uint64_t, Utils::NUM_SQUARES>& magicNumbers,
+                    const std::array<std::array<int, 2>, N>& deltas) {
+        std::size_t offset = 0;
+        for (int square = 0; square < Utils::NUM_SQUARES; square++) {
+            Attacks::Magic& magic = magics[square];
+            const Bitboard mask = relevantMask(square, deltas);
+
+            Bitboard* const squareAttacks = table.data() + offset;
+            magic.attacks = squareAttacks;
+            magic.mask = mask.raw();
+            magic.magic = magicNumbers[square];
+            magic.shift = Utils::NUM_SQUARES - __builtin_popcountll(mask.raw());
+
+            // enumerate every subset of the mask (Carry-Rippler trick) and store its attacks
+            uint64_t subset = 0;
+            do {
+                squareAttacks[Attacks::tableIndex<Backend>(magic, Bitboard{subset})] = slidingAttacks(square, Bitboard{subset}, deltas);
+                subset = (subset - mask.raw()) & mask.raw();
+            } while (subset != 0);
+
+            offset += 1ULL << (Utils::NUM_SQUARES - magic.shift);
+        }
+    }
+
+    // Fill the ray tables used by the Portable backend.
+    void initRays() {
+        int direction = 0;
+        for (const auto& deltas : {Utils::rookDeltas, Utils::bishopDeltas}) {
+            for (const auto& delta : deltas) {
+                const std::array<std::array<int, 2>, 1> singleDelta{delta};
+                for (int square = 0; square < Utils::NUM_SQUARES; square++) {
+                    rays[direction][square] = slidingAttacks(square, Bitboard{0}, singleDelta);
+                }
+                direction++;
+            }
+        }
+    }
+
+    // Attacks along one ray, stopping at the nearest blocker.
+    Bitboard rayAttacks(int square, Bitboard occupancy, int direction) {
+        const Bitboard ray = rays[direction][square];
+        const Bitboard blockers = ray.mask(occupancy);
+        if (blockers.empty()) {
+            return ray;
+        }
+
+        // rays towards higher squares are blocked first by the LSB, rays towards lower squares by the MSB
+        const bool increasing = ray.lsbIndex() > square;
+        const int blocker = increasing ? blockers.lsbIndex() : blockers.msbIndex();
+
+        // everything past the blocker is hidden behind it
+        return ray.mask(rays[direction][blocker].flip());
+    }
+
+    // Build the attack tables for a table backend.
+    template<Attacks::SliderBackend Backend>
+    void initSliderTables() {
+        initMagics<Backend>(Attacks::rookMagics, rookAttackTable, ROOK_MAGIC_NUMBERS, Utils::rookDeltas);
+        initMagics<Backend>(Attacks::bishopMagics, bishopAttackTable, BISHOP_MAGIC_NUMBERS, Utils::bishopDeltas);
+        Attacks::rookAttacksFn = Attacks::tableRookAttacks<Backend>;
+        Attacks::bishopAttacksFn = Attacks::tableBishopAttacks<Backend>;
+    }
+
+    // Point the slider lookups at the current backend, building its attack tables first. Portable needs only the rays.
+    void selectBackend() {
+        switch (Attacks::sliderBackend) {
+            case Attacks::SliderBackend::Portable:
+                Attacks::rookAttacksFn = Attacks::portableRookAttacks;
+                Attacks::bishopAttacksFn = Attacks::portableBishopAttacks;
+                break;
+            case Attacks::SliderBackend::Magic:
+                initSliderTables<Attacks::SliderBackend::Magic>();
+                break;
+            case Attacks::SliderBackend::Pext:
+                initSliderTables<Attacks::SliderBackend::Pext>();
+                break;
+        }
+    }
+} // namespace
+
+void Attacks::init() {
+    // function-local static is initialized exactly once, even with multiple threads
+    static const bool initialized = [] {
+        initRays();
+
+        sliderBackend = detectBackend();
+        const char* override = std::getenv("CHESS_SLIDER_BACKEND"); // NOLINT(concurrency-mt-unsafe) read once, before any threads exist
+        if (override != nullptr) {
+            const std::string_view name{override};
+            if (name == "portable") {
+                sliderBackend = SliderBackend::Portable;
+            } else if (name == "magic") {
+                sliderBackend = SliderBackend::Magic;
+            } else if (name == "pext" && cpuSupportsPext()) {
+                sliderBackend = SliderBackend::Pext;
+            }
+        }
+
+        selectBackend();
+        return true;
+    }();
+    (void)initialized;
+}
+
+bool Attacks::cpuSupportsPext() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+#else
+    return false;
+#endif
+}
+
+Attacks::SliderBackend Attacks::detectBackend() {
+    if (!cpuSupportsPext()) {
+        return SliderBackend::Magic;
+    }
+
+#if defined(__x86_64__)
+    // Zen 1 and Zen 2 implement PEXT in microcode; it is many times slower than a magic multiply there
+    if (__builtin_cpu_is("amd") && (__builtin_cpu_is("znver1") || __builtin_cpu_is("znver2"))) {
+        return SliderBackend::Magic;
+    }
+#endif
+
+    return SliderBackend::Pext;
+}
+
+void Attacks::setBackend(SliderBackend backend) {
+    init();
+    if (backend == SliderBackend::Pext && !cpuSupportsPext()) {
+        backend = SliderBackend::Magic;
+    }
+    sliderBackend = backend;
+    selectBackend();
+}
+
+const char* Attacks::backendName(SliderBackend backend) {
+    switch (backend) {
+        case SliderBackend::Portable: return "portable";
+        case SliderBackend::Magic: return "magic";
+        case SliderBackend::Pext: return "pext";
+    }
+    return "unknown";
+}
+
+Bitboard Attacks::portableRookAttacks(int square, Bitboard occupancy) {
+    Bitboard attacks{0};
+    for (int direction = 0; direction < NUM_ROOK_DIRECTIONS; direction++) {
+        attacks.mergeIn(rayAttacks(square, occupancy, direction));
+    }
+    return attacks;
+}
+
+Bitboard Attacks::portableBishopAttacks(int square, Bitboard occupancy) {
+    Bitboard attacks{0};
+    for (int direction = NUM_ROOK_DIRECTIONS; direction < NUM_DIRECTIONS; direction++) {
+        attacks.mergeIn(rayAttacks(square, occupancy, direction));
+    }
+    return attacks;
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "Bitboard.hpp"
+#include "Utils.hpp"
+
+// Attack lookup tables shared by every Game.
+//
+// Knight, king, and pawn attacks do not depend on occupancy, so they are computed at compile time.
+//
+// Slider attack generation. Every square has a mask of the squares whose occupancy can change its attacks, and a slice
+// of a shared attack table holding the attacks for every subset of that mask. The backend decides how a masked
+// occupancy becomes an index into the slice:
+//  - Magic: multiply by the square's magic number and shift down. See https://www.chessprogramming.org/Magic_Bitboards
+//  - Pext: gather the masked bits with BMI2 PEXT. Fastest on CPUs with a hardware PEXT (Intel Haswell+, AMD Zen 3+).
+//  - Portable: no attack table; scan each ray for its nearest blocker. Fallback for debugging and unusual hosts.
+// The backend is picked at runtime by init(), so one build runs at full speed on every host.
+namespace Attacks {
+    // Squares attacked from each square by a piece that jumps by the given deltas. Used to build tables at compile time.
+    template<std::size_t N>
+    constexpr std::array<Bitboard, Utils::NUM_SQUARES> leaperAttacks(const std::array<std::array<int, 2>, N>& deltas) {
+        std::array<Bitboard, Utils::NUM_SQUARES> attacks{};
+        for (int square = 0; square < Utils::NUM_SQUARES; square++) {
+            for (const auto& delta : deltas) {
+                const int curCol = Utils::getCol(square) + delta[0];
+                const int curRow = Utils::getRow(square) + delta[1];
+                if (Utils::onBoard(curCol, curRow)) {
+                    attacks[square].setSquare(Utils::getSquareIndex(curCol, curRow));
+                }
+            }
+        }
+        return attacks;
+    }
+
+    // Pawns capture diagonally forwards; white moves towards row 0, black towards row 7.
+    static constexpr std::array<std::array<int, 2>, 2> whitePawnAttackDeltas {{{-1, -1}, {1, -1}}};
+    static constexpr std::array<std::array<int, 2>, 2> blackPawnAttackDeltas {{{-1, 1}, {1, 1}}};
+
+    // Leaper attack tables, indexed by the square the piece is on.
+    inline constexpr std::array<Bitboard, Utils::NUM_SQUARES> KNIGHT_ATTACKS = leaperAttacks(Utils::knightDeltas);
+    inline constexpr std::array<Bitboard, Utils::NUM_SQUARES> KING_ATTACKS = leaperAttacks(Utils::kingDeltas);
+    inline constexpr std::array<Bitboard, Utils::NUM_SQUARES> WHITE_PAWN_ATTACKS = leaperAttacks(whitePawnAttackDeltas);
+    inline constexpr std::array<Bitboard, Utils::NUM_SQUARES> BLACK_PAWN_ATTACKS = leaperAttacks(blackPawnAttackDeltas);
+
+    using SquarePairTable = std::array<std::array<Bitboard, Utils::NUM_SQUARES>, Utils::NUM_SQUARES>;
+
+    // Squares from a square towards the board edge in one direction, on an empty board. Excludes the square itself.
+    constexpr Bitboard emptyBoardRay(int square, int colDelta, int rowDelta) {
+        Bitboard ray;
+        int curCol = Utils::getCol(square) + colDelta;
+        int curRow = Utils::getRow(square) + rowDelta;
+        while (Utils::onBoard(curCol, curRow)) {
+            ray.setSquare(Utils::getSquareIndex(curCol, curRow));
+            curCol += colDelta;
+            curRow += rowDelta;
+        }
+        return ray;
+    }
+
+    // Squares strictly between two squares sharing a rank, file, or diagonal. Empty if the squares are not aligned.
+    constexpr SquarePairTable betweenTable() {
+        SquarePairTable between{};
+        for (int square = 0; square < Utils::NUM_SQUARES; square++) {
+            for (const auto& delta : Utils::queenDeltas) {
+                // walk away from square, remembering every square passed on the way
+                Bitboard passed;
+                int curCol = Utils::getCol(square) + delta[0];
+                int curRow = Utils::getRow(square) + delta[1];
+                while (Utils::onBoard(curCol, curRow)) {
+                    const int target = Utils::getSquareIndex(curCol, curRow);
+                    between[square][target] = passed;
+                    passed.setSquare(target);
+                    curCol += delta[0];
+                    curRow += delta[1];
+                }
+            }
+        }
+        return between;
+    }
+
+    // Every square of the rank, file, or diagonal through two squares, edge to edge. Empty if the squares are not aligned.
+    constexpr SquarePairTable lineTable() {
+        SquarePairTable line{};
+        for (int square = 0; square < Utils::NUM_SQUARES; square++) {
+            for (const auto& delta : Utils::queenDeltas) {
+                Bitboard ray = emptyBoardRay(square, delta[0], delta[1]);
+                Bitboard fullLine = ray.merge(emptyBoardRay(square, -delta[0], -delta[1]));
+                fullLine.setSquare(square);
+                while (!ray.empty()) {
+                    line[square][ray.popLsb()] = fullLine;
+                }
+            }
+        }
+        return line;
+    }
+
+    // Squares between and lines through two squares, indexed [square][square]. Used for pins and blocking checks.
+    inline constexpr SquarePairTable BETWEEN = betweenTable();
+    inline constexpr SquarePairTable LINE = lineTable();
+
+    // Strategies for slider attack lookup.
+    enum class SliderBackend : uint8_t {
+        Portable,
+        Magic,
+        Pext
+    };
+
+    // Magic lookup information for one square.
+    struct Magic {
+        // Pointer to this square's slice of the attack table.
+        const Bitboard* attacks;
+        // Relevant occupancy of the square; the ray squares excluding the board edge.
+        uint64_t mask;
+        // Magic number which maps each relevant occupancy to its attack set without harmful collisions.
+        uint64_t magic;
+        // 64 - number of bits in the mask.
+        uint32_t shift;
+
+        // Index into attacks for the given board occupancy.
+        constexpr uint32_t index(uint64_t occupancy) const noexcept {
+            return static_cast<uint32_t>(((occupancy & mask) * magic) >> shift);
+        }
+    } __attribute__((aligned(32))); // NOLINT[magic numbers] align to 32 bytes
+
+    // Total number of attack sets for every square; sum of 2^(mask bits) over all squares.
+    static constexpr int ROOK_TABLE_SIZE = 102'400;
+    static constexpr int BISHOP_TABLE_SIZE = 5'248;
+
+    // Signature shared by every backend's rook and bishop lookups.
+    using SliderAttacks = Bitboard (*)(int square, Bitboard occupancy);
+
+    // Backend in use. Set by init() or setBackend(), together with the lookups below.
+    extern SliderBackend sliderBackend; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+    // Lookups of the backend in use, chosen once so that a slider lookup does not test the backend each time.
+    extern SliderAttacks rookAttacksFn; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+    extern SliderAttacks bishopAttacksFn; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+    // Lookups for each square. Filled by init() for the Magic and Pext backends only.
+    extern std::array<Magic, Utils::NUM_SQUARES> rookMagics;
+    extern std::array<Magic, Utils::NUM_SQUARES> bishopMagics;
+
+    // Detect the CPU and build the attack tables for its best backend, if it needs any. Only the first call does any work, so it is safe
+    // to call from every Game. The CHESS_SLIDER_BACKEND environment variable (portable, magic, pext) overrides detection.
+    void init();
+    // Best backend for the CPU we are running on.
+    SliderBackend detectBackend();
+    // If the CPU supports BMI2 PEXT at all, fast or not.
+    bool cpuSupportsPext();
+    // Switch backends and rebuild the tables it needs. Not thread safe; only meant for tests and benchmarks.
+    void setBackend(SliderBackend backend);
+    // Readable backend name, e.g., "magic".
+    const char* backendName(SliderBackend backend);
+
+    // Ray-scanning attacks used by the Portable backend.
+    Bitboard portableRookAttacks(int square, Bitboard occupancy);
+    Bitboard portableBishopAttacks(int square, Bitboard occupancy);
+
+    // Parallel bit extract: pack the bits of value selected by mask into the low bits of the result.
+    inline uint64_t pext(uint64_t value, uint64_t mask) noexcept {
+#if defined(__BMI2__)
+        return _pext_u64(value, mask);
+#elif defined(__x86_64__)
+        // not compiled for BMI2, but only reached when init() found it on this CPU; the assembler accepts it regardless
+        uint64_t result = 0;
+        asm("pextq %2, %1, %0" : "=r"(result) : "r"(value), "r"(mask));
+        return result;
+#else
+        // no PEXT on this architecture; detectBackend() never picks Pext, but keep a correct software version
+        uint64_t result = 0;
+        for (uint64_t bit = 1; mask != 0; bit <<= 1) {
+            if ((value & mask & -mask) != 0) {
+                result |= bit;
+            }
+            mask &= mask - 1;
+        }
+        return result;
+#endif
+    }
+
+    // Index into a square's attack slice for a table backend.
+    template<SliderBackend Backend>
+    inline uint32_t tableIndex(const Magic& magic, Bitboard occupancy) noexcept {
+        static_assert(Backend != SliderBackend::Portable, "the Portable backend has no attack table");
+        if constexpr (Backend == SliderBackend::Pext) {
+            return static_cast<uint32_t>(pext(occupancy.raw(), magic.mask));
+        }
+        return magic.index(occupancy.raw());
+    }
+
+    // Rook and bishop attacks looked up in the attack table of a table backend.
+    template<SliderBackend Backend>
+    Bitboard tableRookAttacks(int square, Bitboard occupancy) noexcept {
+        const Magic& magic = rookMagics[square];
+        return magic.attacks[tableIndex<Backend>(magic, occupancy)];
+    }
+
+    template<SliderBackend Backend>
+    Bitboard tableBishopAttacks(int square, Bitboard occupancy) noexcept {
+        const Magic& magic = bishopMagics[square];
+        return magic.attacks[tableIndex<Backend>(magic, occupancy)];
+    }
+
+    // Rook attacks from a square given the occupancy of the board. Includes the first blocker in each direction, of either color.
+    inline Bitboard rookAttacks(int square, Bitboard occupancy) noexcept {
+        return rookAttacksFn(square, occupancy);
+    }
+
+    // Bishop attacks from a square given the occupancy of the board. Includes the first blocker in each direction, of either color.
+    inline Bitboard bishopAttacks(int square, Bitboard occupancy) noexcept {
+        return bishopAttacksFn(square, occupancy);
+    }
+
+    // Queen attacks from a square given the occupancy of the board.
+    inline Bitboard queenAttacks(int square, Bitboard occupancy) noexcept {
+        return rookAttacks(square, occupancy).merge(bishopAttacks(square, occupancy));
+    }
+} // namespace Attacks
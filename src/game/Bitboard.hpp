@@ -35,6 +35,9 @@ public:
     // Clear entire bitboard.
     constexpr void clear() { bitboard_ = 0; }
 
+    // Flip every square set in other; set squares become clear and clear squares become set.
+    constexpr void toggle(const Bitboard& other) { bitboard_ ^= other.bitboard_; }
+
     // Mask current bitboard with other bitboard.
     constexpr Bitboard mask(const Bitboard& other) const { return Bitboard{bitboard_ & other.bitboard_}; }
 
@@ -53,6 +56,8 @@ public:
 
     constexpr int lsbIndex() const { return __builtin_ctzll(bitboard_); }
     constexpr int msbIndex() const { return (Utils::NUM_SQUARES - 1) - __builtin_clzll(bitboard_); }
+    // If more than one square is set.
+    constexpr bool hasMultiple() const { return (bitboard_ & (bitboard_ - 1)) != 0; }
 
     // Get LSB of bitboard. Bitboard must be nonzero.
     constexpr int popLsb() {
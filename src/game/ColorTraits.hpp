@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+
+#include "Attacks.hpp"
+#include "Bitboard.hpp"
+#include "Piece.hpp"
+#include "Utils.hpp"
+
+// Everything that differs between white and black, fixed at compile time. Code templated on the side to move reads
+// its directions, ranks, and castling squares from here instead of branching on the color at runtime.
+template<Color Us>
+struct ColorTraits {
+    static_assert(Us != Color::None, "ColorTraits needs a real color");
+
+    static constexpr bool IS_WHITE = Us == Color::White;
+    // The opponent.
+    static constexpr Color THEM = IS_WHITE ? Color::Black : Color::White;
+
+    // Square offset of a single pawn push; white pawns move towards row 0.
+    static constexpr int PUSH = IS_WHITE ? -Utils::BOARD_WIDTH : Utils::BOARD_WIDTH;
+    // Row our pawns promote on.
+    static constexpr int PROMOTION_ROW = IS_WHITE ? 0 : Utils::BOARD_HEIGHT - 1;
+    static constexpr Bitboard PROMOTION_RANK{IS_WHITE ? Bitboard::Rank8 : Bitboard::Rank1};
+    // Rank a double push lands on.
+    static constexpr Bitboard DOUBLE_PUSH_RANK{IS_WHITE ? Bitboard::Rank4 : Bitboard::Rank5};
+    // Squares our pawns attack, indexed by the pawn's square.
+    static constexpr const std::array<Bitboard, Utils::NUM_SQUARES>& PAWN_ATTACKS = IS_WHITE ? Attacks::WHITE_PAWN_ATTACKS : Attacks::BLACK_PAWN_ATTACKS;
+
+    // Castling squares.
+    static constexpr int KING_STARTING_SQUARE = IS_WHITE ? Utils::WHITE_KING_STARTING_SQUARE : Utils::BLACK_KING_STARTING_SQUARE;
+    static constexpr int KINGSIDE_PASSING_SQUARE = IS_WHITE ? Utils::WHITE_KINGSIDE_PASSING_SQUARE : Utils::BLACK_KINGSIDE_PASSING_SQUARE;
+    static constexpr int KINGSIDE_TARGET_SQUARE = IS_WHITE ? Utils::WHITE_KINGSIDE_TARGET_SQUARE : Utils::BLACK_KINGSIDE_TARGET_SQUARE;
+    static constexpr int KINGSIDE_ROOK_STARTING_SQUARE = IS_WHITE ? Utils::WHITE_KINGSIDE_ROOK_STARTING_SQUARE : Utils::BLACK_KINGSIDE_ROOK_STARTING_SQUARE;
+    static constexpr int QUEENSIDE_PASSING_SQUARE = IS_WHITE ? Utils::WHITE_QUEENSIDE_PASSING_SQUARE : Utils::BLACK_QUEENSIDE_PASSING_SQUARE;
+    static constexpr int QUEENSIDE_TARGET_SQUARE = IS_WHITE ? Utils::WHITE_QUEENSIDE_TARGET_SQUARE : Utils::BLACK_QUEENSIDE_TARGET_SQUARE;
+    static constexpr int QUEENSIDE_ROOK_STARTING_SQUARE = IS_WHITE ? Utils::WHITE_QUEENSIDE_ROOK_STARTING_SQUARE : Utils::BLACK_QUEENSIDE_ROOK_STARTING_SQUARE;
+    // Squares the king stands on, passes through, and lands on when castling; none of them may be attacked.
+    static constexpr Bitboard KINGSIDE_KING_PATH{Bitboard::bit(KING_STARTING_SQUARE) | Bitboard::bit(KINGSIDE_PASSING_SQUARE) | Bitboard::bit(KINGSIDE_TARGET_SQUARE)};
+    static constexpr Bitboard QUEENSIDE_KING_PATH{Bitboard::bit(KING_STARTING_SQUARE) | Bitboard::bit(QUEENSIDE_PASSING_SQUARE) | Bitboard::bit(QUEENSIDE_TARGET_SQUARE)};
+
+    // Move every square in bitboard one pawn push forward.
+    static constexpr Bitboard push(const Bitboard& bitboard) noexcept {
+        return IS_WHITE ? bitboard.rightShift(Utils::BOARD_WIDTH) : bitboard.leftShift(Utils::BOARD_WIDTH);
+    }
+};
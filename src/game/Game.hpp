@@ -4,11 +4,16 @@
 #include <cassert>
 #include <cstdint>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
+#include "Attacks.hpp"
 #include "Bitboard.hpp"
+#include "ColorTraits.hpp"
 #include "Move.hpp"
 #include "Piece.hpp"
 #include "Utils.hpp"
+#include "Zobrist.hpp"
 
 // Representation of the castling rights of a position, stored in uint8_t for maximum speed.
 struct CastlingRights {
@@ -39,84 +44,142 @@ struct CastlingRights {
     constexpr void clearBlackQueenside() noexcept { castlingRights &= ~(1 << 3); }
 };
 
-// Info used to fully undo a move.
-struct UndoInfo {
-    // Store previous state
-    CastlingRights prevCastlingRights;
-    uint8_t prevEnPassantSquare;
-    Piece capturedPiece;
-
+// State of a position that unmaking a move restores rather than recomputes, such as castling rights. Game holds only
+// the current one; making a move saves it to the caller's copy before updating it, and unmaking the move restores that
+// copy. The history is the caller's, so copying a Game copies no history.
+struct StateInfo {
     static constexpr uint8_t noEnPassant = 255;
 
-    constexpr UndoInfo(CastlingRights castlingRights,
-                       uint8_t enPassantSquare,
-                       Piece capturedPiece_) noexcept
-        : prevCastlingRights{castlingRights},
-          prevEnPassantSquare{enPassantSquare},
-          capturedPiece{capturedPiece_} {}
-} __attribute__((aligned(4))); // align to 4 bytes
-
-// Create holder for all AttackBitboards
-struct AttackBitboards {
-    std::array<Bitboard, Utils::NUM_SQUARES> whitePawnAttacks{};
-    std::array<Bitboard, Utils::NUM_SQUARES> blackPawnAttacks{};
-    std::array<Bitboard, Utils::NUM_SQUARES> knightAttacks{};
-    std::array<Bitboard, Utils::NUM_SQUARES> kingAttacks{};
-
-    std::array<Bitboard, Utils::NUM_SQUARES> northRay, southRay, eastRay, westRay;
-    std::array<Bitboard, Utils::NUM_SQUARES> neRay, nwRay, seRay, swRay;
-} __attribute__((aligned(128))); // NOLINT[magic numbers] align to 128 bytes
-
-// A chess game. Contains information for the game and helpers to generate and validate moves.
-class Game {
+    // Zobrist key of the position.
+    uint64_t hash{0};
+    // Enemy pieces giving check to the side to move.
+    Bitboard checkers;
+    // Plies since the last capture or pawn move, for the fifty move rule.
+    uint16_t halfmoveClock{0};
+    // Starts at 1 and increases after every black move.
+    uint16_t fullmoveNumber{1};
+    // Castling flags.
+    CastlingRights castlingRights{0};
+    // Current en passant square. Is noEnPassant if no en passant.
+    uint8_t enPassantSquare{noEnPassant};
+    // Piece captured by the move that reached this position; put back when the move is unmade.
+    Piece capturedPiece;
+    // The side to move.
+    Color sideToMove{Color::White};
+};
+static_assert(sizeof(StateInfo) == 24, "the fields fill three words; Game's size assumes no padding"); // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+// Restrictions on the moves a generator may emit. The defaults place no restrictions, which gives pseudo legal moves.
+struct MoveMasks {
+    // Squares a non-king move may land on. When in check, the checker and the squares between it and our king.
+    Bitboard targets{~0ULL};
+    // Our pieces pinned to our king. They may only move along the line through the king and the pinner.
+    Bitboard pinned;
+    // Enemy pieces giving check.
+    Bitboard checkers;
+    // Square of our king.
+    int kingSquare{0};
+    // If king moves, castling, and en passant are checked against enemy attacks.
+    bool legal{false};
+    // If captures, en passant, and promotions are emitted.
+    bool captures{true};
+    // If quiet moves are emitted; every move that is not a capture or a promotion, including castling.
+    bool quiets{true};
+} __attribute__((aligned(32))); // NOLINT[magic numbers] align to 32 bytes
+
+// A chess game. Contains information for the game and helpers to generate and validate moves. Exactly two cache lines
+// of plain values, so that a copy (e.g., one per search or perft thread) is a memcpy of two lines.
+class alignas(64) Game { // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers) cache line size
 public:
     // Construct a new game with an empty board. Current turn defaults to white.
     Game();
-    // Update the board given a FEN.
-    void loadFEN(const std::string& FEN);
+    // Replace the position with the one given by a FEN. Does not allocate, so it is cheap to call for many positions.
+    void loadFEN(std::string_view FEN);
 
-    // Retrieve mailbox.
-    constexpr std::array<Piece, Utils::NUM_SQUARES> mailbox() const noexcept { return mailbox_; }
+    // Retrieve the piece on a square, or an empty piece. Reads the mailbox, so it is cheap enough for hot loops.
+    constexpr Piece pieceAt(int square) const noexcept {
+        return Piece::fromRaw(mailbox_[square / SQUARES_PER_WORD_] >> mailboxShift_(square));
+    }
     // Retrieve the color of the current player's turn.
-    constexpr Color sideToMove() const noexcept { return sideToMove_; }
+    constexpr Color sideToMove() const noexcept { return state_.sideToMove; }
+    // Retrieve the Zobrist key of the position; updated incrementally by makeMove and unmakeMove.
+    constexpr uint64_t hash() const noexcept { return state_.hash; }
+    // Retrieve the enemy pieces giving check to the side to move. Found once per makeMove.
+    constexpr Bitboard checkers() const noexcept { return state_.checkers; }
+    // If the side to move is in check.
+    constexpr bool inCheck() const noexcept { return !state_.checkers.empty(); }
+    // Retrieve plies since the last capture or pawn move.
+    constexpr int halfmoveClock() const noexcept { return state_.halfmoveClock; }
+    // Retrieve the full move number.
+    constexpr int fullmoveNumber() const noexcept { return state_.fullmoveNumber; }
+    // Compute the Zobrist key of the position from scratch. Slow; used to set and validate the incremental key.
+    uint64_t computeHash() const noexcept;
     // Retrieve a string representation of the current state of the board.
     std::string to_string() const;
     // If the game is finished.
     bool isFinished();
-    // Get flags in the form of UndoInfo.
-    constexpr UndoInfo getUndoInfo(Piece capturedPiece) const noexcept {
-        // pack bools into castling rights uint8_t for speedy lookup
-        return UndoInfo{
-            castlingRights_,
-            enPassantSquare_,
-            capturedPiece
-        };
-    }
-
-    constexpr UndoInfo getUndoInfo(Move move) const noexcept {
-        // pack bools into castling rights uint8_t for speedy lookup
-        return UndoInfo{
-            castlingRights_,
-            enPassantSquare_,
-            mailbox_[move.targetSquare()]
-        };
-    }
     // Get piece at a square for the GUI. Note this method is relatively slow and should not be used in hot loops.
     Piece pieceAtSquareForGui(int square) const noexcept;
-    // Try a move and return if the move was made. The move is only made if it is legal.
+    // Try a move and return if the move was made. The move is only made if it is legal. The move becomes part of the
+    // game and can not be unmade.
     bool tryMove(const Move& move);
-    // Make a move, even if it is not legal.
-    void makeMove(const Move& move);
-    // Make a move and return the necessary undoInfo
-    UndoInfo makeMoveWithUndoInfo(const Move& move);
-    // Undo a move. Does not check if the move we are undoing happened before.
-    void undoMove(const Move& move, const UndoInfo& undoInfo);
+    // Make a move, even if it is not legal. The state before the move is saved to saved, which unmakeMove needs back;
+    // callers keep one per ply of their search, usually on their own call stack.
+    void makeMove(const Move& move, StateInfo& saved) {
+        if(state_.sideToMove == Color::White) {
+            makeMove<Color::White>(move, saved);
+        } else {
+            makeMove<Color::Black>(move, saved);
+        }
+    }
+    // Make a move for Us, which must be the side to move. Lets a caller that already knows the side skip the dispatch.
+    template<Color Us>
+    void makeMove(const Move& move, StateInfo& saved);
+    // Unmake the last move made, given the state makeMove saved for it. Does not check if move was really the last move.
+    void unmakeMove(const Move& move, const StateInfo& saved) {
+        // the side that made the move is no longer the side to move
+        if(state_.sideToMove == Color::Black) {
+            unmakeMove<Color::White>(move, saved);
+        } else {
+            unmakeMove<Color::Black>(move, saved);
+        }
+    }
+    // Unmake the last move made, which Us made.
+    template<Color Us>
+    void unmakeMove(const Move& move, const StateInfo& saved);
+    // Pass the turn without moving a piece, for null move pruning. Saves the state like makeMove. Not legal chess: the
+    // side to move must not be in check.
+    constexpr void makeNullMove(StateInfo& saved) noexcept {
+        assert(!inCheck());
+        saved = state_;
+        StateInfo& state = state_;
+        state.capturedPiece = Piece{};
+
+        // passing forfeits the en passant capture
+        if(state.enPassantSquare != StateInfo::noEnPassant) {
+            state.hash ^= Zobrist::enPassantKey(state.enPassantSquare);
+            state.enPassantSquare = StateInfo::noEnPassant;
+        }
+
+        if(state.sideToMove == Color::Black) {
+            state.fullmoveNumber++;
+        }
+        state.halfmoveClock++;
+        state.sideToMove = oppositeColor(state.sideToMove);
+        state.hash ^= Zobrist::sideKey();
+        // no piece moved and the side that passed was not in check, so the enemy can not be in check either
+        state.checkers = Bitboard{};
+    }
+    // Undo the last null move, given the state makeNullMove saved for it. The saved state holds the side to move too.
+    constexpr void undoNullMove(const StateInfo& saved) noexcept {
+        state_ = saved;
+    }
     // If a move is legal.
     bool isMoveLegal(const Move& move);
     // If a move puts us in check (including castling through check). This has to be called after the move is made
     constexpr bool doesMovePutUsInCheck(const Move& move) const {
         // since move has already been played, targetColor is currentColor
-        const Color targetColor = sideToMove_;
+        const Color targetColor = state_.sideToMove;
         const Color moveColor = oppositeColor(targetColor);
         const bool isSourceWhite = moveColor == Color::White;
 
@@ -125,60 +188,69 @@ public:
             return true;
         }
         
-        // castling legality rules
-        if(move.isKingSideCastle()) {
-            const int kingStartingSquare = isSourceWhite ? Utils::WHITE_KING_STARTING_SQUARE : Utils::BLACK_KING_STARTING_SQUARE;
-            const int kingsidePassingSquare = isSourceWhite ? Utils::WHITE_KINGSIDE_PASSING_SQUARE : Utils::BLACK_KINGSIDE_PASSING_SQUARE;
-            const int kingsideTargetSquare = isSourceWhite ? Utils::WHITE_KINGSIDE_TARGET_SQUARE : Utils::BLACK_KINGSIDE_TARGET_SQUARE;
-
-            if(
-                isSquareAttacked(kingStartingSquare, targetColor) ||   // king cant start in check
-                isSquareAttacked(kingsidePassingSquare, targetColor) ||   // king cant pass through check 
-                isSquareAttacked(kingsideTargetSquare, targetColor)      // king cant end in check
-            ) {
-                return true;
+        // castling legality rules; the king can not start in, pass through, or end in check
+        if(move.isKingSideCastle() || move.isQueenSideCastle()) {
+            Bitboard path;
+            if(move.isKingSideCastle()) {
+                path = isSourceWhite ? ColorTraits<Color::White>::KINGSIDE_KING_PATH : ColorTraits<Color::Black>::KINGSIDE_KING_PATH;
+            } else {
+                path = isSourceWhite ? ColorTraits<Color::White>::QUEENSIDE_KING_PATH : ColorTraits<Color::Black>::QUEENSIDE_KING_PATH;
             }
-        }
 
-        if(move.isQueenSideCastle()) {
-            const int kingStartingSquare = isSourceWhite ? Utils::WHITE_KING_STARTING_SQUARE : Utils::BLACK_KING_STARTING_SQUARE;
-            const int queensidePassingSquare = isSourceWhite ? Utils::WHITE_QUEENSIDE_PASSING_SQUARE : Utils::BLACK_QUEENSIDE_PASSING_SQUARE;
-            const int queensideTargetSquare = isSourceWhite ? Utils::WHITE_QUEENSIDE_TARGET_SQUARE : Utils::BLACK_QUEENSIDE_TARGET_SQUARE;
-            if(
-                isSquareAttacked(kingStartingSquare, targetColor) ||   // king cant start in check
-                isSquareAttacked(queensidePassingSquare, targetColor) ||   // king cant pass through check 
-                isSquareAttacked(queensideTargetSquare, targetColor)      // king cant end in check
-            ) {
+            // gather the attackers of every square on the path, then test them against the enemy in one go
+            Bitboard attackers;
+            while(!path.empty()) {
+                attackers.mergeIn(attackersTo(path.popLsb(), bbAllPieces_));
+            }
+            if(attackers.intersects(colorToOccupancyBitboard(targetColor))) {
                 return true;
             }
         }
 
         return false;
     }
-    // Generate all legal moves.
-    void generateLegalMoves(MoveList& out);
+    // Generate all legal moves. Checkers and pins are found once up front, so no move has to be made to test it.
+    void generateLegalMoves(MoveList& out) const noexcept {
+        if(state_.sideToMove == Color::White) {
+            generateLegalMoves<Color::White>(out);
+        } else {
+            generateLegalMoves<Color::Black>(out);
+        }
+    }
+    // Generate all legal moves for Us, which must be the side to move.
+    template<Color Us>
+    void generateLegalMoves(MoveList& out) const noexcept;
+    // Generate legal captures and promotions, including quiet promotions. Meant for quiescence and staged move ordering.
+    void generateCaptures(MoveList& out) const noexcept;
+    // Generate legal moves that are not captures or promotions, including castling.
+    void generateQuiets(MoveList& out) const noexcept;
+    // Generate legal moves out of check. The side to move must be in check.
+    void generateEvasions(MoveList& out) const noexcept;
     // Generate all legal moves from a sourceSquare. This is slow and should only be used sparingly (e.g., in GUI).
-    void generateLegalMovesFromSquare(int sourceSquare, MoveList& out);
+    void generateLegalMovesFromSquare(int sourceSquare, MoveList& out) const noexcept;
     // Generate all pseudo legal moves. Pseudo legal moves only take piece movement into account, no king check status.
-    constexpr void generatePseudoLegalMoves(MoveList& out) noexcept {
-        generatePseudoLegalPawnMoves_(out);
-        generatePseudoLegalKnightMoves_(out);
-        generatePseudoLegalBishopMoves_(out);
-        generatePseudoLegalRookMoves_(out);
-        generatePseudoLegalQueenMoves_(out);
-        generatePseudoLegalKingMoves_(out);
-    }
+    void generatePseudoLegalMoves(MoveList& out) const noexcept;
+    // Checkers, pins, and check evasion targets of the side to move.
+    MoveMasks legalMoveMasks() const noexcept;
     // If the given color is in check.
     constexpr bool isInCheck(const Color& colorToFind) const noexcept {
         // NOTE: this has undefined behavior if no kings on both sides
         const int kingSquare = findKingSquare(colorToFind);
         return isSquareAttacked(kingSquare, oppositeColor(colorToFind));
     }
+    // Pieces of both colors attacking a square, given the occupancy of the board. Mask with a color's occupancy to get
+    // that color's attackers; pass a modified occupancy to look through or past pieces, e.g., for x-rays or SEE.
+    Bitboard attackersTo(int square, Bitboard occupancy) const noexcept;
     // If a given square is attacked by the attacking color.
-    bool isSquareAttacked(int targetSquare, Color attackingColor) const;
+    bool isSquareAttacked(int targetSquare, Color attackingColor) const {
+        return attackingColor == Color::White ? isSquareAttacked<Color::White>(targetSquare) : isSquareAttacked<Color::Black>(targetSquare);
+    }
+    // If a given square is attacked by Attacker.
+    template<Color Attacker>
+    bool isSquareAttacked(int targetSquare) const;
     // Retrieve king square for a given color. Does not exist if king is not on board.
     constexpr int findKingSquare(const Color& colorToFind) const noexcept {
-        Bitboard bbKing = colorToFind == Color::White ? bbWhiteKing_ : bbBlackKing_;
+        Bitboard bbKing = pieceToBitboard(Piece{PieceType::King, colorToFind});
         // NOTE: this has undefined behavior if bbKing is empty
         return bbKing.popLsb();
     }
@@ -188,126 +260,162 @@ public:
         return (color == Color::White) ? Color::Black : Color::White;
     }
 
-    constexpr AttackBitboards attackBitboards() const noexcept {
-        return attackBitboards_;
-    }
-
-    constexpr Bitboard& colorToOccupancyBitboard(Color color) const noexcept {
-        // use very fast lookup table
-        Bitboard* bitboard = colorToOccupancyBitboard_[static_cast<uint8_t>(color)];
-        return *bitboard;
+    // Get a given color's occupancy bitboard.
+    constexpr Bitboard colorToOccupancyBitboard(Color color) const noexcept {
+        assert(color != Color::None);
+        return bbColors_[colorIndex_(color)];
     }
 
     // Get a given piece's bitboard.
-    constexpr Bitboard& pieceToBitboard(Piece piece) const noexcept {
-        // Use lookup table for quick access
-        Bitboard* const bitboard = piecePackedToBB_[piece.raw()];
-        assert(bitboard != nullptr);
-        return *bitboard;
+    constexpr Bitboard pieceToBitboard(Piece piece) const noexcept {
+        assert(piece.exists());
+        return bbPieceTypes_[pieceTypeIndex_(piece.type())].mask(bbColors_[colorIndex_(piece.color())]);
     }
 
     // Bitboard getters
     // White
-    constexpr Bitboard& bbWhitePawns() {
-        return bbWhitePawns_;
+    constexpr Bitboard bbWhitePawns() const noexcept {
+        return pieceToBitboard(Piece{PieceType::Pawn, Color::White});
     }
-    constexpr Bitboard& bbWhiteKnights() {
-        return bbWhiteKnights_;
+    constexpr Bitboard bbWhiteKnights() const noexcept {
+        return pieceToBitboard(Piece{PieceType::Knight, Color::White});
     }
-    constexpr Bitboard& bbWhiteBishops() {
-        return bbWhiteBishops_;
+    constexpr Bitboard bbWhiteBishops() const noexcept {
+        return pieceToBitboard(Piece{PieceType::Bishop, Color::White});
     }
-    constexpr Bitboard& bbWhiteRooks() {
-        return bbWhiteRooks_;
+    constexpr Bitboard bbWhiteRooks() const noexcept {
+        return pieceToBitboard(Piece{PieceType::Rook, Color::White});
     }
-    constexpr Bitboard& bbWhiteQueens() {
-        return bbWhiteQueens_;
+    constexpr Bitboard bbWhiteQueens() const noexcept {
+        return pieceToBitboard(Piece{PieceType::Queen, Color::White});
     }
-    constexpr Bitboard& bbWhiteKing() {
-        return bbWhiteKing_;
+    constexpr Bitboard bbWhiteKing() const noexcept {
+        return pieceToBitboard(Piece{PieceType::King, Color::White});
     }
 
     // Black
-    constexpr Bitboard& bbBlackPawns() {
-        return bbBlackPawns_;
+    constexpr Bitboard bbBlackPawns() const noexcept {
+        return pieceToBitboard(Piece{PieceType::Pawn, Color::Black});
     }
-    constexpr Bitboard& bbBlackKnights() {
-        return bbBlackKnights_;
+    constexpr Bitboard bbBlackKnights() const noexcept {
+        return pieceToBitboard(Piece{PieceType::Knight, Color::Black});
     }
-    constexpr Bitboard& bbBlackBishops() {
-        return bbBlackBishops_;
+    constexpr Bitboard bbBlackBishops() const noexcept {
+        return pieceToBitboard(Piece{PieceType::Bishop, Color::Black});
     }
-    constexpr Bitboard& bbBlackRooks() {
-        return bbBlackRooks_;
+    constexpr Bitboard bbBlackRooks() const noexcept {
+        return pieceToBitboard(Piece{PieceType::Rook, Color::Black});
     }
-    constexpr Bitboard& bbBlackQueens() {
-        return bbBlackQueens_;
+    constexpr Bitboard bbBlackQueens() const noexcept {
+        return pieceToBitboard(Piece{PieceType::Queen, Color::Black});
     }
-    constexpr Bitboard& bbBlackKing() {
-        return bbBlackKing_;
+    constexpr Bitboard bbBlackKing() const noexcept {
+        return pieceToBitboard(Piece{PieceType::King, Color::Black});
+    }
+
+    // If color has a piece besides its king and pawns.
+    constexpr bool hasNonPawnMaterial(Color color) const noexcept {
+        const uint64_t pawnsAndKing = pieceToBitboard(Piece{PieceType::Pawn, color}).raw() | pieceToBitboard(Piece{PieceType::King, color}).raw();
+        return (colorToOccupancyBitboard(color).raw() & ~pawnsAndKing) != 0;
     }
 
     // Occupancy
-    constexpr Bitboard& bbWhitePieces() {
-        return bbWhitePieces_;
+    constexpr Bitboard bbWhitePieces() const noexcept {
+        return colorToOccupancyBitboard(Color::White);
     }
-    constexpr Bitboard& bbBlackPieces() {
-        return bbBlackPieces_;
+    constexpr Bitboard bbBlackPieces() const noexcept {
+        return colorToOccupancyBitboard(Color::Black);
+    }
+    constexpr Bitboard bbAllPieces() const noexcept {
+        return bbAllPieces_;
     }
 
 private:
-    // mailbox used to quickly find piece from square; not used for generating pieces
-    std::array<Piece, Utils::NUM_SQUARES> mailbox_;
-
-    // The game's current turn.
-    Color sideToMove_;
-
-    // Castling flags.
-    CastlingRights castlingRights_;
-    
-    // Current en passant square. Is UndoInfo sentinal if no en passant.
-    uint8_t enPassantSquare_;
-
-    // Bitboards to keep state
-    // White
-    Bitboard bbWhitePawns_;
-    Bitboard bbWhiteKnights_;
-    Bitboard bbWhiteBishops_;
-    Bitboard bbWhiteRooks_;
-    Bitboard bbWhiteQueens_;
-    Bitboard bbWhiteKing_;
-
-    // Black
-    Bitboard bbBlackPawns_;
-    Bitboard bbBlackKnights_;
-    Bitboard bbBlackBishops_;
-    Bitboard bbBlackRooks_;
-    Bitboard bbBlackQueens_;
-    Bitboard bbBlackKing_;
-
-    // Occupancy
-    Bitboard bbWhitePieces_;
-    Bitboard bbBlackPieces_;
-
-    // Attack bitboards
-    AttackBitboards attackBitboards_;
+    // The position is stored as plain values only (no pointers, member pointers, or history), so a Game is trivially
+    // copyable and copying one is a memcpy.
+    // Piece bitboards are the intersection of a piece type bitboard and a color bitboard.
+    // The bitboards come first, so everything move generation reads sits in the first cache line.
+    static constexpr int NUM_PIECE_TYPES = 6;
+    static constexpr int NUM_COLORS = 2;
+
+    // Bitboards of each piece type, of both colors. Indexed by pieceTypeIndex_().
+    std::array<Bitboard, NUM_PIECE_TYPES> bbPieceTypes_;
+
+    // Occupancy bitboards of each color. Indexed by colorIndex_().
+    std::array<Bitboard, NUM_COLORS> bbColors_;
+
+    // Occupancy of both colors; kept in sync by putPiece_, removePiece_, and movePiece_ rather than merged on demand.
+    Bitboard bbAllPieces_;
+
+    // State of the current position, including the side to move. Earlier states are kept by whoever made the moves.
+    StateInfo state_;
+
+    // mailbox used to quickly find piece from square; not used for generating pieces. Packs each square's Piece::raw()
+    // into 4 bits, eight squares to a word, lowest square in the lowest bits, to keep the Game within two cache lines.
+    // Read through pieceAt(). Words rather than bytes, since a store through a byte may alias any object.
+    static constexpr int SQUARES_PER_WORD_ = 32 / Piece::RAW_BITS;
+    std::array<uint32_t, Utils::NUM_SQUARES / SQUARES_PER_WORD_> mailbox_{};
+
+    // Shift of a square's 4 bits within its mailbox word.
+    static constexpr int mailboxShift_(int square) noexcept {
+        return (square % SQUARES_PER_WORD_) * Piece::RAW_BITS;
+    }
+    // Put piece on an empty square of the mailbox, or take it off the square it is on. XOR needs no mask, since the
+    // callers always know what is on the square.
+    constexpr void toggleMailbox_(int square, Piece piece) noexcept {
+        mailbox_[square / SQUARES_PER_WORD_] ^= static_cast<uint32_t>(piece.raw()) << mailboxShift_(square);
+    }
 
-    // Lookup table to bb by piece's packed uint8_t representation for quick access
-    static constexpr int numPieceCombinations = 256;
-    std::array<Bitboard*, numPieceCombinations> piecePackedToBB_{};
+    // Index into bbPieceTypes_; PieceType::None has no bitboard.
+    static constexpr int pieceTypeIndex_(PieceType type) noexcept {
+        return static_cast<int>(type) - 1;
+    }
+    // Index into bbColors_; Color::None has no bitboard.
+    static constexpr int colorIndex_(Color color) noexcept {
+        return static_cast<int>(color) - 1;
+    }
 
-    // Lookup table to occupancy board by color's uint8_t representation
-    std::array<Bitboard*, 4> colorToOccupancyBitboard_{nullptr, &bbWhitePieces_, &bbBlackPieces_};
+    // XOR the keys of the castling rights and en passant square into the hash. Called once before the flags change,
+    // to take the old keys out, and once after, to put the new keys in.
+    constexpr void toggleFlagKeys_() noexcept {
+        StateInfo& state = state_;
+        state.hash ^= Zobrist::castlingKey(state.castlingRights.castlingRights);
+        if(state.enPassantSquare != StateInfo::noEnPassant) {
+            state.hash ^= Zobrist::enPassantKey(state.enPassantSquare);
+        }
+    }
 
-    // init lookup tables
-    void initAttackBitboards_();
-    void initPieceToBBTable_();
+    // Place a piece on an empty square.
+    constexpr void putPiece_(Piece piece, int square) noexcept {
+        toggleMailbox_(square, piece);
+        state_.hash ^= Zobrist::pieceKey(piece, square);
+        bbPieceTypes_[pieceTypeIndex_(piece.type())].setSquare(square);
+        bbColors_[colorIndex_(piece.color())].setSquare(square);
+        bbAllPieces_.setSquare(square);
+    }
+    // Remove a piece from the square it is on. Callers pass the piece, which they usually know without a mailbox read.
+    constexpr void removePiece_(Piece piece, int square) noexcept {
+        toggleMailbox_(square, piece);
+        state_.hash ^= Zobrist::pieceKey(piece, square);
+        bbPieceTypes_[pieceTypeIndex_(piece.type())].clearSquare(square);
+        bbColors_[colorIndex_(piece.color())].clearSquare(square);
+        bbAllPieces_.clearSquare(square);
+    }
+    // Move a piece from sourceSquare, where it must be, to an empty targetSquare.
+    constexpr void movePiece_(Piece piece, int sourceSquare, int targetSquare) noexcept {
+        const Bitboard fromTo{Bitboard::bit(sourceSquare) | Bitboard::bit(targetSquare)};
+        toggleMailbox_(targetSquare, piece);
+        toggleMailbox_(sourceSquare, piece);
+        state_.hash ^= Zobrist::pieceKey(piece, sourceSquare) ^ Zobrist::pieceKey(piece, targetSquare);
+        bbPieceTypes_[pieceTypeIndex_(piece.type())].toggle(fromTo);
+        bbColors_[colorIndex_(piece.color())].toggle(fromTo);
+        bbAllPieces_.toggle(fromTo);
+    }
     
     // Add move and all pawn promotion variants to moves. If move is not a pawn promotion, just add move by itself.
-    static constexpr void addAllPawnPromotionsToMoves_(MoveList& moves, int sourceSquare, int targetSquare, Piece sourcePiece, bool isCapture) {
-        const Color pawnColor = sourcePiece.color();
-        const int promotionRow = pawnColor == Color::White ? 0 : 7; 
-        if(Utils::getRow(targetSquare) == promotionRow) {
+    template<Color Us>
+    static constexpr void addAllPawnPromotionsToMoves_(MoveList& moves, int sourceSquare, int targetSquare, bool isCapture) {
+        if(Utils::getRow(targetSquare) == ColorTraits<Us>::PROMOTION_ROW) {
             const MoveFlag flag = isCapture ? MoveFlag::PromotionCapture : MoveFlag::Promotion;
             // add promotions
             moves.push_back(Move{sourceSquare, targetSquare, flag, Promotion::Knight});
@@ -321,16 +429,71 @@ private:
         }
     }
 
-    // Generate all pseudo legal pawn moves.
-    void generatePseudoLegalPawnMoves_(MoveList& out);
-    // Generate all pseudo legal knight moves.
-    void generatePseudoLegalKnightMoves_(MoveList& out);
-    // Generate all pseudo legal bishop moves.
-    void generatePseudoLegalBishopMoves_(MoveList& out);
-    // Generate all pseudo legal rook moves.
-    void generatePseudoLegalRookMoves_(MoveList& out);
-    // Generate all pseudo legal queen moves.
-    void generatePseudoLegalQueenMoves_(MoveList& out);
-    // Generate all pseudo legal king moves.
-    void generatePseudoLegalKingMoves_(MoveList& out);
-};
\ No newline at end of file
+    // Add a normal move for every empty square in attacks, and a capture for every target piece in attacks.
+    static constexpr void addMovesFromAttacks_(MoveList& moves, int sourceSquare, const Bitboard& attacks, const Bitboard& targetPieces) {
+        // Normal moves (non-captures)
+        Bitboard normal = attacks.mask(targetPieces.flip()); // attacks that do not land on target pieces
+        while(!normal.empty()) {
+            const int targetSquare = normal.popLsb();
+            moves.push_back(Move{sourceSquare, targetSquare, MoveFlag::Normal, Promotion::None});
+        }
+
+        // Capture moves
+        Bitboard captures = attacks.mask(targetPieces); // attacks that land on target pieces
+        while(!captures.empty()) {
+            const int targetSquare = captures.popLsb();
+            moves.push_back(Move{sourceSquare, targetSquare, MoveFlag::Capture, Promotion::None});
+        }
+    }
+
+    // Squares a non-pawn piece may land on for the kinds of moves in masks; enemy pieces for captures, empty squares for quiets.
+    static constexpr Bitboard kindTargets_(const MoveMasks& masks, const Bitboard& targetPieces, const Bitboard& allPieces) noexcept {
+        if(!masks.quiets) {
+            return targetPieces;
+        }
+        if(!masks.captures) {
+            return allPieces.flip();
+        }
+        return Bitboard{~0ULL};
+    }
+    // Squares a piece on square may move to without exposing our king; the pin line if it is pinned, otherwise anywhere.
+    static constexpr Bitboard pinLine_(int square, const MoveMasks& masks) noexcept {
+        return masks.pinned.containsSquare(square) ? Attacks::LINE[masks.kingSquare][square] : Bitboard{~0ULL};
+    }
+
+    // If capturing en passant from sourceSquare leaves our king safe. Both pawns leave the capture rank at once, so
+    // pins alone can not catch every case.
+    template<Color Us>
+    bool isEnPassantSafe_(int sourceSquare, int kingSquare) const noexcept;
+    // Checkers, pins, and check evasion targets of Us, the side to move.
+    template<Color Us>
+    MoveMasks legalMoveMasks_() const noexcept;
+
+    // The generators below generate for Us, which must be the side to move. Callers dispatch on the side once.
+    // Run every piece's generator within masks. In double check, only the king moves.
+    template<Color Us>
+    void generateMoves_(MoveList& out, const MoveMasks& masks) const noexcept;
+    // Generate pawn moves within masks.
+    template<Color Us>
+    void generatePawnMoves_(MoveList& out, const MoveMasks& masks) const noexcept;
+    // Generate knight moves within masks.
+    template<Color Us>
+    void generateKnightMoves_(MoveList& out, const MoveMasks& masks) const noexcept;
+    // Generate bishop moves within masks.
+    template<Color Us>
+    void generateBishopMoves_(MoveList& out, const MoveMasks& masks) const noexcept;
+    // Generate rook moves within masks.
+    template<Color Us>
+    void generateRookMoves_(MoveList& out, const MoveMasks& masks) const noexcept;
+    // Generate queen moves within masks.
+    template<Color Us>
+    void generateQueenMoves_(MoveList& out, const MoveMasks& masks) const noexcept;
+    // Generate king moves, including castling. With legal masks, squares the enemy attacks are skipped.
+    template<Color Us>
+    void generateKingMoves_(MoveList& out, const MoveMasks& masks) const noexcept;
+};
+// Copies of a Game must stay cheap: no copy constructor of its own and no more than two cache lines
+static_assert(std::is_trivially_copyable_v<Game>, "a Game must copy as a memcpy");
+static_assert(sizeof(Game) <= 128, "a Game must fit in two cache lines"); // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+#include "Game.inl"
\ No newline at end of file
@@ -0,0 +1,483 @@
+#pragma once
+
+// Definitions of Game's color templates: move generation, make / unmake, and attack queries. They live in a header, so
+// that perft and the search can inline them into their inner loops. Included by Game.hpp; do not include directly.
+
+#include "Game.hpp"
+
+template<Color Us>
+void Game::generatePawnMoves_(MoveList& out, const MoveMasks& masks) const noexcept {
+    using Traits = ColorTraits<Us>;
+
+    Bitboard sourcePawns = pieceToBitboard(Piece{PieceType::Pawn, Us});
+    const Bitboard& targetPieces = colorToOccupancyBitboard(Traits::THEM);
+
+    const Bitboard& emptySquares = bbAllPieces_.flip();
+    const int enPassantSquare = state_.enPassantSquare;
+
+    // promotions count as captures; pushes onto the last rank belong to the captures, every other push to the quiets
+    Bitboard pushTargets = masks.targets;
+    if(!masks.captures) {
+        pushTargets = pushTargets.mask(Traits::PROMOTION_RANK.flip());
+    }
+    if(!masks.quiets) {
+        pushTargets = pushTargets.mask(Traits::PROMOTION_RANK);
+    }
+
+    // Normal moves
+    // shift every pawn one row forward if it lands on an empty square
+    const Bitboard& oneRowPush = Traits::push(sourcePawns).mask(emptySquares);
+
+    Bitboard normal = oneRowPush.mask(pushTargets);
+    while(!normal.empty()) {
+        const int targetSquare = normal.popLsb();
+        const int sourceSquare = targetSquare - Traits::PUSH;
+        // a pinned pawn may only push along its pin line
+        if(!pinLine_(sourceSquare, masks).containsSquare(targetSquare)) {
+            continue;
+        }
+        addAllPawnPromotionsToMoves_<Us>(out, sourceSquare, targetSquare, false);
+    }
+
+    // Double push
+    // shift forward again from 'oneRowPush' to ensure both squares are empty; it must land on the double push rank
+    Bitboard doublePush = Traits::push(oneRowPush).mask(emptySquares).mask(Traits::DOUBLE_PUSH_RANK).mask(pushTargets);
+    while(!doublePush.empty()) {
+        const int targetSquare = doublePush.popLsb();
+        const int sourceSquare = targetSquare - (2 * Traits::PUSH);
+        if(!pinLine_(sourceSquare, masks).containsSquare(targetSquare)) {
+            continue;
+        }
+        // double push can never be a promotion, so we don't need to call addAllPawnPromotionsToMoves_ here
+        out.push_back(Move{sourceSquare, targetSquare, MoveFlag::DoublePawnPush, Promotion::None});
+    }
+
+    // En Passant
+    if (masks.captures && enPassantSquare != StateInfo::noEnPassant) {
+        // we check the enemy's pawn attack pattern because pawn moves are not symmetrical
+        Bitboard attackers = sourcePawns.mask(ColorTraits<Traits::THEM>::PAWN_ATTACKS[enPassantSquare]);
+
+        while (!attackers.empty()) {
+            const int from = attackers.popLsb();
+            if(masks.legal && !isEnPassantSafe_<Us>(from, masks.kingSquare)) {
+                continue;
+            }
+            out.push_back(Move{from, enPassantSquare, MoveFlag::EnPassant, Promotion::None});
+        }
+    }
+
+    // we can now mutate sourcePawns because we're done with the constant operations
+    while(masks.captures && !sourcePawns.empty()) {
+        const int sourceSquare = sourcePawns.popLsb();
+
+        // Normal capture
+        // attacks that land on target pieces, and keep the king safe
+        Bitboard captures = Traits::PAWN_ATTACKS[sourceSquare].mask(targetPieces).mask(masks.targets).mask(pinLine_(sourceSquare, masks));
+        while(!captures.empty()) {
+            const int targetSquare = captures.popLsb();
+            addAllPawnPromotionsToMoves_<Us>(out, sourceSquare, targetSquare, true);
+        }
+    }
+}
+
+
+template<Color Us>
+void Game::generateKnightMoves_(MoveList& out, const MoveMasks& masks) const noexcept {
+    Bitboard sourceKnights = pieceToBitboard(Piece{PieceType::Knight, Us});
+    const Bitboard& sourcePieces = colorToOccupancyBitboard(Us);
+    const Bitboard& targetPieces = colorToOccupancyBitboard(ColorTraits<Us>::THEM);
+    const Bitboard& allPieces = bbAllPieces_;
+    const Bitboard landingSquares = masks.targets.mask(kindTargets_(masks, targetPieces, allPieces));
+
+    while(!sourceKnights.empty()) {
+        const int sourceSquare = sourceKnights.popLsb();
+        // can not attack own pieces; a pinned knight can never stay on its pin line, so it has no moves
+        const Bitboard& attacks = Attacks::KNIGHT_ATTACKS[sourceSquare].mask(sourcePieces.flip()).mask(landingSquares).mask(pinLine_(sourceSquare, masks));
+        addMovesFromAttacks_(out, sourceSquare, attacks, targetPieces);
+    }
+}
+
+template<Color Us>
+void Game::generateBishopMoves_(MoveList& out, const MoveMasks& masks) const noexcept {
+    Bitboard sourceBishops = pieceToBitboard(Piece{PieceType::Bishop, Us});
+    const Bitboard& sourcePieces = colorToOccupancyBitboard(Us);
+    const Bitboard& targetPieces = colorToOccupancyBitboard(ColorTraits<Us>::THEM);
+    const Bitboard& allPieces = bbAllPieces_;
+    const Bitboard landingSquares = masks.targets.mask(kindTargets_(masks, targetPieces, allPieces));
+
+    while (!sourceBishops.empty()) {
+        const int sourceSquare = sourceBishops.popLsb();
+        const Bitboard& attacks = Attacks::bishopAttacks(sourceSquare, allPieces).mask(sourcePieces.flip()).mask(landingSquares).mask(pinLine_(sourceSquare, masks)); // can not attack own pieces
+        addMovesFromAttacks_(out, sourceSquare, attacks, targetPieces);
+    }
+}
+
+template<Color Us>
+void Game::generateRookMoves_(MoveList& out, const MoveMasks& masks) const noexcept {
+    Bitboard sourceRooks = pieceToBitboard(Piece{PieceType::Rook, Us});
+    const Bitboard& sourcePieces = colorToOccupancyBitboard(Us);
+    const Bitboard& targetPieces = colorToOccupancyBitboard(ColorTraits<Us>::THEM);
+    const Bitboard& allPieces = bbAllPieces_;
+    const Bitboard landingSquares = masks.targets.mask(kindTargets_(masks, targetPieces, allPieces));
+
+    while (!sourceRooks.empty()) {
+        const int sourceSquare = sourceRooks.popLsb();
+        const Bitboard& attacks = Attacks::rookAttacks(sourceSquare, allPieces).mask(sourcePieces.flip()).mask(landingSquares).mask(pinLine_(sourceSquare, masks)); // can not attack own pieces
+        addMovesFromAttacks_(out, sourceSquare, attacks, targetPieces);
+    }
+}
+
+template<Color Us>
+void Game::generateQueenMoves_(MoveList& out, const MoveMasks& masks) const noexcept {
+    Bitboard sourceQueens = pieceToBitboard(Piece{PieceType::Queen, Us});
+    const Bitboard& sourcePieces = colorToOccupancyBitboard(Us);
+    const Bitboard& targetPieces = colorToOccupancyBitboard(ColorTraits<Us>::THEM);
+    const Bitboard& allPieces = bbAllPieces_;
+    const Bitboard landingSquares = masks.targets.mask(kindTargets_(masks, targetPieces, allPieces));
+
+    while (!sourceQueens.empty()) {
+        const int sourceSquare = sourceQueens.popLsb();
+        const Bitboard& attacks = Attacks::queenAttacks(sourceSquare, allPieces).mask(sourcePieces.flip()).mask(landingSquares).mask(pinLine_(sourceSquare, masks)); // can not attack own pieces
+        addMovesFromAttacks_(out, sourceSquare, attacks, targetPieces);
+    }
+}
+
+template<Color Us>
+void Game::generateKingMoves_(MoveList& out, const MoveMasks& masks) const noexcept {
+    using Traits = ColorTraits<Us>;
+
+    Bitboard sourceKing = pieceToBitboard(Piece{PieceType::King, Us});
+    const Bitboard& sourcePieces = colorToOccupancyBitboard(Us);
+    const Bitboard& targetPieces = colorToOccupancyBitboard(Traits::THEM);
+    const Bitboard& allPieces = bbAllPieces_;
+
+    // NOTE: because we assume just one king per side, we do not need to loop over all king squares.
+    // for the same reason, we do not need to check if a king exists before using .popLsb();
+    while(!sourceKing.empty()) {
+        const int sourceSquare = sourceKing.popLsb();
+        Bitboard attacks = Attacks::KING_ATTACKS[sourceSquare].mask(sourcePieces.flip()).mask(kindTargets_(masks, targetPieces, allPieces)); // can not attack own pieces
+
+        if(masks.legal) {
+            // drop squares the enemy attacks; the king is lifted off the board so sliders see through its old square
+            Bitboard allPiecesWithoutKing = allPieces;
+            allPiecesWithoutKing.clearSquare(sourceSquare);
+            Bitboard candidates = attacks;
+            while(!candidates.empty()) {
+                const int targetSquare = candidates.popLsb();
+                if(attackersTo(targetSquare, allPiecesWithoutKing).intersects(targetPieces)) {
+                    attacks.clearSquare(targetSquare);
+                }
+            }
+        }
+
+        addMovesFromAttacks_(out, sourceSquare, attacks, targetPieces);
+
+        // Castling
+        // castling is a quiet move, and can not be played out of check
+        if(!masks.quiets || (masks.legal && !masks.checkers.empty())) {
+            continue;
+        }
+
+        const CastlingRights castlingRights = state_.castlingRights;
+        const bool canKingside = Traits::IS_WHITE ? castlingRights.canWhiteKingside() : castlingRights.canBlackKingside();
+        const bool canQueenside = Traits::IS_WHITE ? castlingRights.canWhiteQueenside() : castlingRights.canBlackQueenside();
+
+        // If the enemy attacks a square the king passes through or lands on. Only checked for legal generation.
+        auto isPathAttacked = [&](int passingSquare, int castleTargetSquare) {
+            return masks.legal && (
+                attackersTo(passingSquare, allPieces).intersects(targetPieces) ||
+                attackersTo(castleTargetSquare, allPieces).intersects(targetPieces)
+            );
+        };
+
+        // TODO: bitwise masks instead of allPieces.containsSquare(...)
+        // King side castling
+        if(
+            canKingside &&
+            sourceSquare == Traits::KING_STARTING_SQUARE &&
+            !allPieces.containsSquare(Traits::KINGSIDE_PASSING_SQUARE) &&  // passing square does not contain a piece 
+            !allPieces.containsSquare(Traits::KINGSIDE_TARGET_SQUARE) &&   // target square does not contain a piece
+            !isPathAttacked(Traits::KINGSIDE_PASSING_SQUARE, Traits::KINGSIDE_TARGET_SQUARE)
+        ) {
+            out.push_back(Move{sourceSquare, Traits::KINGSIDE_TARGET_SQUARE, MoveFlag::KingCastle, Promotion::None});
+        }
+
+        // Queen side castling
+        if(
+            canQueenside &&
+            sourceSquare == Traits::KING_STARTING_SQUARE &&
+            !allPieces.containsSquare(Traits::QUEENSIDE_PASSING_SQUARE) &&      // passing square does not contain a piece
+            !allPieces.containsSquare(Traits::QUEENSIDE_PASSING_SQUARE - 2) &&  // queenside has two passing squares
+            !allPieces.containsSquare(Traits::QUEENSIDE_TARGET_SQUARE) &&       // target square does not contain a piece
+            !isPathAttacked(Traits::QUEENSIDE_PASSING_SQUARE, Traits::QUEENSIDE_TARGET_SQUARE)  // the rook may pass an attacked square, the king may not
+        ) {
+            out.push_back(Move{sourceSquare, Traits::QUEENSIDE_TARGET_SQUARE, MoveFlag::QueenCastle, Promotion::None});
+        }
+    }
+}
+
+template<Color Us>
+MoveMasks Game::legalMoveMasks_() const noexcept {
+    constexpr Color enemyColor = ColorTraits<Us>::THEM;
+    const Bitboard& ourPieces = colorToOccupancyBitboard(Us);
+    const Bitboard& enemyPieces = colorToOccupancyBitboard(enemyColor);
+    const Bitboard& allPieces = bbAllPieces_;
+
+    MoveMasks masks;
+    masks.legal = true;
+    masks.kingSquare = findKingSquare(Us);
+    // the checkers were found when the move leading here was made
+    masks.checkers = state_.checkers;
+
+    // in single check, every other piece must capture the checker or block it; in double check, only the king may move
+    if(masks.checkers.hasMultiple()) {
+        masks.targets = Bitboard{};
+    } else if(!masks.checkers.empty()) {
+        const int checkerSquare = masks.checkers.lsbIndex();
+        masks.targets = Attacks::BETWEEN[masks.kingSquare][checkerSquare];
+        masks.targets.setSquare(checkerSquare);
+    }
+
+    // Pins -- enemy sliders that would see our king if none of our pieces were in the way.
+    // If exactly one piece stands between, and it is ours, it is pinned.
+    const Bitboard& enemyQueens = pieceToBitboard(Piece{PieceType::Queen, enemyColor});
+    const Bitboard& rookLike = pieceToBitboard(Piece{PieceType::Rook, enemyColor}).merge(enemyQueens);
+    const Bitboard& bishopLike = pieceToBitboard(Piece{PieceType::Bishop, enemyColor}).merge(enemyQueens);
+    Bitboard pinners = Attacks::rookAttacks(masks.kingSquare, enemyPieces).mask(rookLike)
+        .merge(Attacks::bishopAttacks(masks.kingSquare, enemyPieces).mask(bishopLike));
+    while(!pinners.empty()) {
+        const Bitboard& blockers = Attacks::BETWEEN[masks.kingSquare][pinners.popLsb()].mask(allPieces);
+        if(!blockers.empty() && !blockers.hasMultiple() && blockers.intersects(ourPieces)) {
+            masks.pinned.mergeIn(blockers);
+        }
+    }
+
+    return masks;
+}
+
+template<Color Us>
+void Game::generateLegalMoves(MoveList& out) const noexcept {
+    assert(state_.sideToMove == Us);
+    generateMoves_<Us>(out, legalMoveMasks_<Us>());
+}
+
+template<Color Us>
+void Game::generateMoves_(MoveList& out, const MoveMasks& masks) const noexcept {
+    // in double check, only the king can move
+    if(!masks.checkers.hasMultiple()) {
+        generatePawnMoves_<Us>(out, masks);
+        generateKnightMoves_<Us>(out, masks);
+        generateBishopMoves_<Us>(out, masks);
+        generateRookMoves_<Us>(out, masks);
+        generateQueenMoves_<Us>(out, masks);
+    }
+    generateKingMoves_<Us>(out, masks);
+}
+
+template<Color Us>
+void Game::makeMove(const Move& move, StateInfo& saved) {
+    using Traits = ColorTraits<Us>;
+    assert(state_.sideToMove == Us);
+    const Piece sourcePiece = pieceAt(move.sourceSquare());
+
+    // save the current state for unmakeMove; the new state is updated in place below
+    saved = state_;
+    StateInfo& state = state_;
+    state.capturedPiece = Piece{};
+
+    // take the current flags out of the hash; the updated flags go back in below
+    toggleFlagKeys_();
+
+    // flip current turn
+    state.sideToMove = Traits::THEM;
+    state.hash ^= Zobrist::sideKey();
+    // remove en passant (we may set it again later in this function)
+    state.enPassantSquare = StateInfo::noEnPassant;
+
+    // update castling flags
+    if(
+        move.sourceSquare() == Utils::WHITE_KING_STARTING_SQUARE ||
+        move.sourceSquare() == Utils::WHITE_KINGSIDE_ROOK_STARTING_SQUARE ||
+        move.targetSquare() == Utils::WHITE_KINGSIDE_ROOK_STARTING_SQUARE // white kingside rook captured
+    ) {
+        state.castlingRights.clearWhiteKingside();
+    }
+    if(
+        move.sourceSquare() == Utils::WHITE_KING_STARTING_SQUARE ||
+        move.sourceSquare() == Utils::WHITE_QUEENSIDE_ROOK_STARTING_SQUARE || // moving white queenside pieces
+        move.targetSquare() == Utils::WHITE_QUEENSIDE_ROOK_STARTING_SQUARE // white queenside rook captured
+    ) {
+        state.castlingRights.clearWhiteQueenside();
+    }
+    if(
+        move.sourceSquare() == Utils::BLACK_KING_STARTING_SQUARE ||
+        move.sourceSquare() == Utils::BLACK_KINGSIDE_ROOK_STARTING_SQUARE || // moving black kingside pieces
+        move.targetSquare() == Utils::BLACK_KINGSIDE_ROOK_STARTING_SQUARE // black kingside rook captured
+    ) {
+        state.castlingRights.clearBlackKingside();
+    }
+    if(
+        move.sourceSquare() == Utils::BLACK_KING_STARTING_SQUARE ||
+        move.sourceSquare() == Utils::BLACK_QUEENSIDE_ROOK_STARTING_SQUARE || // moving black queenside pieces
+        move.targetSquare() == Utils::BLACK_QUEENSIDE_ROOK_STARTING_SQUARE // black queenside rook captured
+    ) {
+        state.castlingRights.clearBlackQueenside();
+    }
+
+    // update en passant flag
+    if(move.isDoublePawn()) {
+        // the square that was passed in the double move
+        state.enPassantSquare = move.sourceSquare() + Traits::PUSH;
+    }
+
+    // flags are final, put them back in the hash
+    toggleFlagKeys_();
+
+    // pawn moves and captures reset the fifty-move clock; the move number goes up once black has moved
+    if(sourcePiece.type() == PieceType::Pawn || move.isCapture()) {
+        state.halfmoveClock = 0;
+    } else {
+        state.halfmoveClock++;
+    }
+    if constexpr(!Traits::IS_WHITE) {
+        state.fullmoveNumber++;
+    }
+
+    // If en passant capture, remove the captured pawn
+    if (move.isEnPassant()) {
+        // the captured pawn sits one push behind the target square
+        state.capturedPiece = Piece{PieceType::Pawn, Traits::THEM};
+        removePiece_(state.capturedPiece, move.targetSquare() - Traits::PUSH);
+    }
+
+    // If king side castle, also move the rook
+    if(move.isKingSideCastle()) {
+        movePiece_(Piece{PieceType::Rook, Us}, Traits::KINGSIDE_ROOK_STARTING_SQUARE, Traits::KINGSIDE_PASSING_SQUARE);
+    }
+
+    // If queen side castle, also move the rook
+    if(move.isQueenSideCastle()) {
+        movePiece_(Piece{PieceType::Rook, Us}, Traits::QUEENSIDE_ROOK_STARTING_SQUARE, Traits::QUEENSIDE_PASSING_SQUARE);
+    }
+
+    // handle capture
+    if(move.isCapture() && !move.isEnPassant()) { // en passant already handles capture separately
+        state.capturedPiece = pieceAt(move.targetSquare());
+        removePiece_(state.capturedPiece, move.targetSquare());
+    }
+
+    // handle pawn promotion; the pawn is replaced by the promoted piece
+    if(move.isPromotion()) {
+        const PieceType promotionType = Move::promotionToPieceType(move.promotion());
+        removePiece_(sourcePiece, move.sourceSquare());
+        putPiece_(Piece{promotionType, Us}, move.targetSquare());
+    } else {
+        movePiece_(sourcePiece, move.sourceSquare(), move.targetSquare());
+    }
+
+    // the side to move now is the side that may be in check
+    state.checkers = attackersTo(findKingSquare(Traits::THEM), bbAllPieces_).mask(colorToOccupancyBitboard(Us));
+
+    assert(state.hash == computeHash());
+}
+
+template<Color Us>
+void Game::unmakeMove(const Move& move, const StateInfo& saved) {
+    using Traits = ColorTraits<Us>;
+    assert(state_.sideToMove == Traits::THEM);
+    const Piece capturedPiece = state_.capturedPiece;
+
+    // undo the general move; a promoted piece turns back into a pawn
+    if(move.isPromotion()) {
+        removePiece_(Piece{Move::promotionToPieceType(move.promotion()), Us}, move.targetSquare());
+        putPiece_(Piece{PieceType::Pawn, Us}, move.sourceSquare());
+    } else {
+        movePiece_(pieceAt(move.targetSquare()), move.targetSquare(), move.sourceSquare());
+    }
+
+    // handle capture
+    if(move.isCapture() && !move.isEnPassant()) {
+        putPiece_(capturedPiece, move.targetSquare());
+    }
+
+    // handle king side castle
+    if(move.isKingSideCastle()) {
+        movePiece_(Piece{PieceType::Rook, Us}, Traits::KINGSIDE_PASSING_SQUARE, Traits::KINGSIDE_ROOK_STARTING_SQUARE);
+    }
+
+    // handle queen side castle
+    if(move.isQueenSideCastle()) {
+        movePiece_(Piece{PieceType::Rook, Us}, Traits::QUEENSIDE_PASSING_SQUARE, Traits::QUEENSIDE_ROOK_STARTING_SQUARE);
+    }
+
+    // handle en passant
+    if(move.isEnPassant()) {
+        putPiece_(capturedPiece, move.targetSquare() - Traits::PUSH);
+    }
+
+    // restore the saved state; it holds the side to move, flags, clocks, and key from before the move
+    // (the piece updates above also touched the current key, which is simply overwritten)
+    state_ = saved;
+
+    assert(state_.hash == computeHash());
+}
+
+template<Color Attacker>
+bool Game::isSquareAttacked(const int targetSquare) const {
+    constexpr Color attackingColor = Attacker;
+    const Bitboard& allPieces = bbAllPieces_;
+    // we compute "is attackingColor attacking targetSquare"
+    // Pawns -- since pawn moves are not symmetric we use the opposite color's attacking bitboard
+    const Bitboard& attackingPawns = pieceToBitboard(Piece{PieceType::Pawn, attackingColor});
+    if(!attackingPawns.mask(ColorTraits<ColorTraits<Attacker>::THEM>::PAWN_ATTACKS[targetSquare]).empty()) {
+        return true;
+    }
+
+    // Knights -- is there an attacking knight sitting a knights move away from targetSquare
+    const Bitboard& attackingKnights = pieceToBitboard(Piece{PieceType::Knight, attackingColor});
+    if(!attackingKnights.mask(Attacks::KNIGHT_ATTACKS[targetSquare]).empty()) {
+        return true;
+    }
+
+    // Kings -- is there an attacking king sitting a kings move away from targetSquare
+    const Bitboard& attackingKings = pieceToBitboard(Piece{PieceType::King, attackingColor});
+    if(!attackingKings.mask(Attacks::KING_ATTACKS[targetSquare]).empty()) {
+        return true;
+    }
+
+    // Sliding pieces -- look up the slider attacks from targetSquare; if they land on an attacking slider, it sees targetSquare
+    const Bitboard& attackingRooks = pieceToBitboard(Piece{PieceType::Rook, attackingColor});
+    const Bitboard& attackingBishops = pieceToBitboard(Piece{PieceType::Bishop, attackingColor});
+    const Bitboard& attackingQueens = pieceToBitboard(Piece{PieceType::Queen, attackingColor});
+    // Orthogonal, rook / queen
+    const Bitboard& rookLike = attackingRooks.merge(attackingQueens);
+    if(Attacks::rookAttacks(targetSquare, allPieces).intersects(rookLike)) {
+        return true;
+    }
+
+    // Diagonal, bishop / queen
+    const Bitboard& bishopLike = attackingBishops.merge(attackingQueens);
+    if(Attacks::bishopAttacks(targetSquare, allPieces).intersects(bishopLike)) {
+        return true;
+    }
+
+    return false;
+}
+
+template<Color Us>
+bool Game::isEnPassantSafe_(const int sourceSquare, const int kingSquare) const noexcept {
+    const int enPassantSquare = state_.enPassantSquare;
+    // the captured pawn sits one push behind the en passant square
+    const int capturedSquare = enPassantSquare - ColorTraits<Us>::PUSH;
+
+    // play the capture on a copy of the occupancy: our pawn leaves sourceSquare, their pawn leaves capturedSquare
+    Bitboard occupancy = bbAllPieces_;
+    occupancy.clearSquare(sourceSquare);
+    occupancy.clearSquare(capturedSquare);
+    occupancy.setSquare(enPassantSquare);
+
+    // the captured pawn can no longer give check, so leave it out of the attackers
+    Bitboard enemyPieces = colorToOccupancyBitboard(ColorTraits<Us>::THEM);
+    enemyPieces.clearSquare(capturedSquare);
+    return !attackersTo(kingSquare, occupancy).intersects(enemyPieces);
+}
@@ -21,7 +21,8 @@ enum class PieceType: uint8_t  {
     King
 };
 
-// A chess piece, with a piece type and color. Stored in uint8_t as (PieceType | Color).
+// A chess piece, with a piece type and color. Stored in the low 4 bits of a uint8_t as (PieceType | black << 3), so that
+// two pieces fit in a byte; an empty square is 0.
 class Piece {
 public:
     // Construct an empty piece, which represents an empty square.
@@ -34,10 +35,20 @@ public:
 
     // Setters use bitwise ops to quickly extract info from packed_.
     constexpr PieceType type() const noexcept { return static_cast<PieceType>(packed_ & TYPE_MASK); }
-    constexpr Color color() const noexcept { return static_cast<Color>((packed_ >> 3) & COLOR_MASK); }
+    // Branch free: White (1) or Black (2) for a piece, times 0 for an empty square, which gives None.
+    constexpr Color color() const noexcept { return static_cast<Color>((1 + (packed_ >> TYPE_BITS)) * static_cast<uint8_t>(exists())); }
     // Retrieve if the piece exists. i.e., if the piece is not an empty square.
     constexpr bool exists() const noexcept { return (packed_ & TYPE_MASK) != 0; } // 0 -> PieceType::None
     constexpr uint8_t raw() const noexcept { return packed_; }
+    // Construct a piece from its raw() value.
+    static constexpr Piece fromRaw(uint8_t raw) noexcept {
+        Piece piece;
+        piece.packed_ = raw & RAW_MASK;
+        return piece;
+    }
+
+    // Number of bits raw() uses.
+    static constexpr uint8_t RAW_BITS = 4;
 
     // Retrieve a string of length one which represents the piece. Uppercase for white, lowercase for black. E.g., white pawn -> "P"
     std::string to_string_short() const;
@@ -53,14 +64,13 @@ protected:
     // packed representation of PieceType | Color. 
     uint8_t packed_;
 
-    // 3 bits for type, 2 for color, and corresponding bitmasks
+    // 3 bits for type, 1 for black, and corresponding bitmasks
     static constexpr uint8_t TYPE_BITS = 3;
-    static constexpr uint8_t COLOR_BITS = 2;
     static constexpr uint8_t TYPE_MASK = (1 << TYPE_BITS) - 1;
-    static constexpr uint8_t COLOR_MASK = (1 << COLOR_BITS) - 1;
+    static constexpr uint8_t RAW_MASK = (1 << RAW_BITS) - 1;
 
     // Pack PieceType and Color into uint8_t
     static constexpr uint8_t pack_(PieceType type, Color color) noexcept {
-        return (static_cast<uint8_t>(type) & TYPE_MASK) | ((static_cast<uint8_t>(color) & COLOR_MASK) << 3);
+        return (static_cast<uint8_t>(type) & TYPE_MASK) | (static_cast<uint8_t>(color == Color::Black) << TYPE_BITS);
     }
 };
\ No newline at end of file
@@ -11,7 +11,7 @@ std::string Utils::intToAlgebraicNotation(const int square) {
     return file + rank;
 }
 
-int Utils::algebraicNotationToInt(const std::string& square) {
+int Utils::algebraicNotationToInt(std::string_view square) {
     // Assume length of exactly 2
     const char colC = square.at(0);
     const char rowC = square.at(1);
@@ -2,6 +2,7 @@
 
 #include <array>
 #include <string>
+#include <string_view>
 
 namespace Utils {
     // --- Constant variables ---
@@ -146,5 +147,5 @@ namespace Utils {
     std::string intToAlgebraicNotation(int square);
 
     // Retrieve square int from a given algebraic notation. E.g., "a8" -> 0.
-    int algebraicNotationToInt(const std::string& square);
+    int algebraicNotationToInt(std::string_view square);
 } // namespace Utils
\ No newline at end of file
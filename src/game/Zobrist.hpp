@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "Piece.hpp"
+#include "Utils.hpp"
+
+// Zobrist hashing. A position's key is the XOR of a key for every piece on its square, plus keys for the side to move,
+// the castling rights, and the en passant file. Making a move only has to XOR out what changed and XOR in the
+// replacement. See https://www.chessprogramming.org/Zobrist_Hashing
+//
+// Keys are generated at compile time from a fixed seed, so every build and every run agree on them.
+namespace Zobrist {
+    // Number of distinct packed Piece values, see Piece::raw(). Only twelve are real pieces; the rest stay zero.
+    static constexpr int NUM_PIECE_CODES = 1 << Piece::RAW_BITS;
+    // Number of distinct packed castling rights, see CastlingRights.
+    static constexpr int NUM_CASTLING_RIGHTS = 16;
+
+    // NOLINTBEGIN(readability-magic-numbers, cppcoreguidelines-avoid-magic-numbers) generator constants and seed
+    // SplitMix64; a small, well mixed generator that is easy to evaluate at compile time.
+    constexpr uint64_t splitMix64(uint64_t& state) noexcept {
+        state += 0x9E3779B97F4A7C15ULL;
+        uint64_t mixed = state;
+        mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+        return mixed ^ (mixed >> 31);
+    }
+
+    // Every key used for hashing.
+    struct Keys {
+        // Indexed by packed piece and square.
+        std::array<std::array<uint64_t, Utils::NUM_SQUARES>, NUM_PIECE_CODES> pieces{};
+        // Indexed by packed castling rights. No rights hashes to zero.
+        std::array<uint64_t, NUM_CASTLING_RIGHTS> castling{};
+        // Indexed by the column of the en passant square.
+        std::array<uint64_t, Utils::BOARD_WIDTH> enPassantFile{};
+        // XORed in when black is to move.
+        uint64_t blackToMove{};
+    };
+
+    // Build every key from a fixed seed.
+    constexpr Keys makeKeys() noexcept {
+        uint64_t state = 0x2545F4914F6CDD1DULL; // arbitrary seed
+        Keys keys;
+
+        for (const Color color : {Color::White, Color::Black}) {
+            for (const PieceType type : {PieceType::Pawn, PieceType::Knight, PieceType::Bishop, PieceType::Rook, PieceType::Queen, PieceType::King}) {
+                for (int square = 0; square < Utils::NUM_SQUARES; square++) {
+                    keys.pieces[Piece{type, color}.raw()][square] = splitMix64(state);
+                }
+            }
+        }
+
+        // one key per right; each combination of rights is the XOR of its rights' keys
+        constexpr int NUM_RIGHTS = 4;
+        std::array<uint64_t, NUM_RIGHTS> rightKeys{};
+        for (uint64_t& rightKey : rightKeys) {
+            rightKey = splitMix64(state);
+        }
+        for (int rights = 0; rights < NUM_CASTLING_RIGHTS; rights++) {
+            for (int right = 0; right < NUM_RIGHTS; right++) {
+                if ((rights & (1 << right)) != 0) {
+                    keys.castling[rights] ^= rightKeys[right];
+                }
+            }
+        }
+
+        for (uint64_t& fileKey : keys.enPassantFile) {
+            fileKey = splitMix64(state);
+        }
+
+        keys.blackToMove = splitMix64(state);
+        return keys;
+    }
+    // NOLINTEND(readability-magic-numbers, cppcoreguidelines-avoid-magic-numbers)
+
+    inline constexpr Keys KEYS = makeKeys();
+
+    // Key for a piece on a square.
+    constexpr uint64_t pieceKey(Piece piece, int square) noexcept {
+        return KEYS.pieces[piece.raw()][square];
+    }
+    // Key for packed castling rights.
+    constexpr uint64_t castlingKey(uint8_t castlingRights) noexcept {
+        return KEYS.castling[castlingRights];
+    }
+    // Key for an en passant square. Only its column matters; the row follows from the side to move.
+    constexpr uint64_t enPassantKey(int square) noexcept {
+        return KEYS.enPassantFile[Utils::getCol(square)];
+    }
+    // Key XORed in when black is to move.
+    constexpr uint64_t sideKey() noexcept {
+        return KEYS.blackToMove;
+    }
+} // namespace Zobrist
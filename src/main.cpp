@@ -2,10 +2,12 @@
 #include <iostream>
 #include <optional>
 #include <string>
+#include <string_view>
 
 #include <SFML/Audio.hpp>
 #include <SFML/Graphics.hpp>
 
+#include "engine/Bench.hpp"
 #include "engine/Engine.hpp"
 #include "game/Game.hpp"
 #include "game/Utils.hpp"
@@ -179,7 +181,7 @@ void runGUIBitboardTest() {
                     // no currently held piece
                     if(!heldSquare) {
                         // no need to do additional processing for clicking on empty square, or wrong player's piece
-                        if(!game.mailbox().at(targetSquare).exists() || game.mailbox().at(targetSquare).color() != game.sideToMove()) {
+                        if(!game.pieceAt(targetSquare).exists() || game.pieceAt(targetSquare).color() != game.sideToMove()) {
                             continue;
                         }
 
@@ -213,7 +215,7 @@ void runGUIBitboardTest() {
                     }
                     
                     // Try to make click-click move; if successful, update visual board
-                    const Move potentialMove = Move::fromPieces(sourceSquare, targetSquare, game.mailbox().at(sourceSquare), game.mailbox().at(targetSquare));
+                    const Move potentialMove = Move::fromPieces(sourceSquare, targetSquare, game.pieceAt(sourceSquare), game.pieceAt(targetSquare));
                     if(game.tryMove(potentialMove)) {
                         board.updateBoardFromGame(game);
                         PIECE_MOVEMENT_SOUND.play();
@@ -281,7 +283,7 @@ void runGUIBitboardTest() {
                     }
 
                     // move is on board and different square
-                    const Move potentialMove = Move::fromPieces(sourceSquare, targetSquare, game.mailbox().at(sourceSquare), game.mailbox().at(targetSquare));
+                    const Move potentialMove = Move::fromPieces(sourceSquare, targetSquare, game.pieceAt(sourceSquare), game.pieceAt(targetSquare));
                     // if move is legal, try it
                     if (game.tryMove(potentialMove)) {
                         board.updateBoardFromGame(game);
@@ -299,7 +301,7 @@ void runGUIBitboardTest() {
         window.clear(sf::Color::Black);
 
         // TODO: replace check highlight with sprite
-        if(game.isInCheck(game.sideToMove())) {
+        if(game.inCheck()) {
             // add check highlight after main loop to override other highlights
             board.at(game.findKingSquare(game.sideToMove())).setHighlight(Board::CHECK_HIGHLIGHT);
         }
@@ -461,7 +463,7 @@ void run2PlayerGUIgame() {
                     // no currently held piece
                     if(!heldSquare) {
                         // no need to do additional processing for clicking on empty square, or wrong player's piece
-                        if(!game.mailbox().at(targetSquare).exists() || game.mailbox().at(targetSquare).color() != game.sideToMove()) {
+                        if(!game.pieceAt(targetSquare).exists() || game.pieceAt(targetSquare).color() != game.sideToMove()) {
                             continue;
                         }
 
@@ -495,7 +497,7 @@ void run2PlayerGUIgame() {
                     }
                     
                     // Try to make click-click move; if successful, update visual board
-                    const Move potentialMove = Move::fromPieces(sourceSquare, targetSquare, game.mailbox().at(sourceSquare), game.mailbox().at(targetSquare));
+                    const Move potentialMove = Move::fromPieces(sourceSquare, targetSquare, game.pieceAt(sourceSquare), game.pieceAt(targetSquare));
                     if(game.tryMove(potentialMove)) {
                         board.updateBoardFromGame(game);
                         PIECE_MOVEMENT_SOUND.play();
@@ -563,7 +565,7 @@ void run2PlayerGUIgame() {
                     }
 
                     // move is on board and different square
-                    const Move potentialMove = Move::fromPieces(sourceSquare, targetSquare, game.mailbox().at(sourceSquare), game.mailbox().at(targetSquare));
+                    const Move potentialMove = Move::fromPieces(sourceSquare, targetSquare, game.pieceAt(sourceSquare), game.pieceAt(targetSquare));
                     // if move is legal, try it
                     if (game.tryMove(potentialMove)) {
                         board.updateBoardFromGame(game);
@@ -587,7 +589,7 @@ void run2PlayerGUIgame() {
         // }
 
         // TODO: replace check highlight with sprite
-        if(game.isInCheck(game.sideToMove())) {
+        if(game.inCheck()) {
             // add check highlight after main loop to override other highlights
             board.at(game.findKingSquare(game.sideToMove())).setHighlight(Board::CHECK_HIGHLIGHT);
         }
@@ -725,7 +727,7 @@ void run1PlayerGUIgame() {
                     // no currently held piece
                     if(!heldSquare) {
                         // no need to do additional processing for clicking on empty square, or wrong player's piece
-                        if(!game.mailbox().at(targetSquare).exists() || game.mailbox().at(targetSquare).color() != game.sideToMove()) {
+                        if(!game.pieceAt(targetSquare).exists() || game.pieceAt(targetSquare).color() != game.sideToMove()) {
                             continue;
                         }
 
@@ -759,7 +761,7 @@ void run1PlayerGUIgame() {
                     }
                     
                     // Try to make click-click move; if successful, update visual board
-                    const Move potentialMove = Move::fromPieces(sourceSquare, targetSquare, game.mailbox().at(sourceSquare), game.mailbox().at(targetSquare));
+                    const Move potentialMove = Move::fromPieces(sourceSquare, targetSquare, game.pieceAt(sourceSquare), game.pieceAt(targetSquare));
                     if(game.tryMove(potentialMove)) {
                         board.updateBoardFromGame(game);
                         PIECE_MOVEMENT_SOUND.play();
@@ -827,7 +829,7 @@ void run1PlayerGUIgame() {
                     }
 
                     // move is on board and different square
-                    const Move potentialMove = Move::fromPieces(sourceSquare, targetSquare, game.mailbox().at(sourceSquare), game.mailbox().at(targetSquare));
+                    const Move potentialMove = Move::fromPieces(sourceSquare, targetSquare, game.pieceAt(sourceSquare), game.pieceAt(targetSquare));
                     // if move is legal, try it
                     if (game.tryMove(potentialMove)) {
                         board.updateBoardFromGame(game);
@@ -852,7 +854,7 @@ void run1PlayerGUIgame() {
 
         // TODO: replace check highlight with sprite
         board.clearAllHighlights(Board::CHECK_HIGHLIGHT);
-        if(game.isInCheck(game.sideToMove())) {
+        if(game.inCheck()) {
             // add check highlight after main loop to override other highlights
             board.at(game.findKingSquare(game.sideToMove())).setHighlight(Board::CHECK_HIGHLIGHT);
         }
@@ -890,9 +892,13 @@ void run1PlayerGUIgame() {
         // Nodes Searched: n
         // QNodes Searched: q
         // Positions Searched: n + q
+        // Hash Full: h permille
+        // Depth: d
         statsText.setString("Nodes Searched: " + std::to_string(currentStats.nodes) +
                             "\nQNodes Searched: " + std::to_string(currentStats.qnodes) +
-                            "\nPositions Searched: " + std::to_string(currentStats.nodes + currentStats.qnodes));
+                            "\nPositions Searched: " + std::to_string(currentStats.nodes + currentStats.qnodes) +
+                            "\nHash Full: " + std::to_string(currentStats.hashfull) + " permille" +
+                            "\nDepth: " + std::to_string(currentStats.depth));
         statsText.setPosition(statsTextPosition);
         statsText.setFillColor(sf::Color::White);
         statsText.setCharacterSize(statsTextFontSize);
@@ -903,6 +909,17 @@ void run1PlayerGUIgame() {
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
+    // "chess bench [depth] [threads]" searches the bench positions and prints the node signature instead of opening the GUI
+    if(argc >= 2 && std::string_view{argv[1]} == "bench") {
+        Bench::runAndPrint(argc >= 3 ? std::stoi(argv[2]) : Bench::DEFAULT_DEPTH, argc >= 4 ? std::stoi(argv[3]) : 1);
+        return 0;
+    }
+    // "chess smpbench [depth] [max threads]" prints how the search scales with threads
+    if(argc >= 2 && std::string_view{argv[1]} == "smpbench") {
+        Bench::runScaling(argc >= 3 ? std::stoi(argv[2]) : Bench::DEFAULT_DEPTH, argc >= 4 ? std::stoi(argv[3]) : Bench::DEFAULT_MAX_THREADS);
+        return 0;
+    }
+
     run1PlayerGUIgame();
 }
@@ -1,65 +1,255 @@
+#include <array>
 #include <cstdint>
+#include <deque>
 #include <iostream>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
 
 #include "Perft.hpp"
 #include "../src/game/Game.hpp"
 
-// limit of 18,446,744,073,709,551,615
-uint64_t Perft::perft(Game& game, int depth) { // NOLINT(misc-no-recursion)
-    if(depth <= 0) {
-        return 1;
+namespace {
+    // Perft with the side to move fixed at compile time; each ply flips it, so the color is dispatched once per call.
+    // With Bulk, the last ply counts the legal moves instead of making each one.
+    template<Color Us, bool Bulk>
+    uint64_t perft_(Game& game, int depth) { // NOLINT(misc-no-recursion)
+        if(depth <= 0) {
+            return 1;
+        }
+
+        MoveList moves;
+        game.generateLegalMoves<Us>(moves);
+
+        // every generated move is legal, so the count at depth 1 is the number of leaves
+        if(Bulk && depth == 1) {
+            return moves.size;
+        }
+
+        uint64_t numPositions = 0;
+        StateInfo saved;
+        for (int i = 0; i < moves.size; i++) {
+            const Move& move = moves.data[i];
+
+            game.makeMove<Us>(move, saved);
+
+            // every move is legal, we can continue recursing
+            numPositions += perft_<ColorTraits<Us>::THEM, Bulk>(game, depth - 1);
+
+            game.unmakeMove<Us>(move, saved);
+        }
+
+        return numPositions;
     }
-    
-    uint64_t numPositions = 0;
-    MoveList moves;
-    game.generatePseudoLegalMoves(moves);
 
-    for (int i = 0; i < moves.size; i++) {
-        const Move& move = moves.data[i];
-        const UndoInfo undoInfo = game.getUndoInfo(game.mailbox()[move.targetSquare()]);
+    // Bulk perft that caches the count of every subtree of depth 2 or more in table.
+    template<Color Us>
+    uint64_t perftHashed_(Game& game, int depth, PerftTable& table) { // NOLINT(misc-no-recursion)
+        if(depth <= 1) {
+            return perft_<Us, true>(game, depth);
+        }
+
+        uint64_t numPositions = 0;
+        if(table.probe(game.hash(), depth, numPositions)) {
+            return numPositions;
+        }
 
-        game.makeMove(move);
+        MoveList moves;
+        game.generateLegalMoves<Us>(moves);
+        StateInfo saved;
+        for (int i = 0; i < moves.size; i++) {
+            const Move& move = moves.data[i];
 
-        if(game.doesMovePutUsInCheck(move)) {
-            game.undoMove(move, undoInfo);
-            continue;
+            game.makeMove<Us>(move, saved);
+            numPositions += perftHashed_<ColorTraits<Us>::THEM>(game, depth - 1, table);
+            game.unmakeMove<Us>(move, saved);
         }
 
-        // no checks, we can continue recursing
-        numPositions += perft(game, depth - 1);
-        
-        game.undoMove(move, undoInfo);
+        table.store(game.hash(), depth, numPositions);
+        return numPositions;
     }
 
-    return numPositions;
+    // A subtree for one thread to count: the moves leading to it from the root, and the root move it belongs to.
+    struct PerftTask {
+        std::array<Move, 2> path{};
+        int pathLength{0};
+        int rootIndex{0};
+    };
+
+    // Split the tree below game into tasks. Tasks start at the root moves, or at the replies to them if there are too
+    // few root moves to give every thread a few tasks to balance with.
+    std::vector<PerftTask> splitTasks_(Game& game, int depth, int numThreads) {
+        constexpr int TASKS_PER_THREAD = 4;
+
+        MoveList rootMoves;
+        game.generateLegalMoves(rootMoves);
+        const bool splitDeeper = depth > 2 && rootMoves.size < numThreads * TASKS_PER_THREAD;
+
+        std::vector<PerftTask> tasks;
+        for(int i = 0; i < rootMoves.size; i++) {
+            const Move& move = rootMoves.data[i];
+            if(!splitDeeper) {
+                tasks.push_back(PerftTask{{move}, 1, i});
+                continue;
+            }
+
+            // a root move without replies has no leaves this deep, so it needs no task
+            StateInfo saved;
+            game.makeMove(move, saved);
+            MoveList replies;
+            game.generateLegalMoves(replies);
+            for(int j = 0; j < replies.size; j++) {
+                tasks.push_back(PerftTask{{move, replies.data[j]}, 2, i});
+            }
+            game.unmakeMove(move, saved);
+        }
+        return tasks;
+    }
+
+    // Per-thread queues of task indices. A thread takes tasks from the back of its own queue; once that is empty, it
+    // steals from the front of the others'.
+    class WorkStealingQueues {
+    public:
+        explicit WorkStealingQueues(int numQueues) : queues_(numQueues) {}
+
+        void push(int queue, int task) {
+            const std::lock_guard<std::mutex> lock(queues_[queue].mutex);
+            queues_[queue].tasks.push_back(task);
+        }
+
+        // Next task for the thread owning queue, or nothing once every queue is empty.
+        std::optional<int> pop(int queue) {
+            const int numQueues = static_cast<int>(queues_.size());
+            for(int offset = 0; offset < numQueues; offset++) {
+                Queue_& victim = queues_[(queue + offset) % numQueues];
+                const std::lock_guard<std::mutex> lock(victim.mutex);
+                if(victim.tasks.empty()) {
+                    continue;
+                }
+                int task = 0;
+                if(offset == 0) {
+                    task = victim.tasks.back();
+                    victim.tasks.pop_back();
+                } else {
+                    task = victim.tasks.front();
+                    victim.tasks.pop_front();
+                }
+                return task;
+            }
+            return std::nullopt;
+        }
+
+    private:
+        struct Queue_ {
+            std::mutex mutex;
+            std::deque<int> tasks;
+        };
+        std::vector<Queue_> queues_;
+    };
+
+    // Count the leaves of every task on numThreads threads. Returns the counts indexed like tasks.
+    std::vector<uint64_t> countTasks_(const Game& game, int depth, const std::vector<PerftTask>& tasks, int numThreads, PerftTable* table) {
+        std::vector<uint64_t> counts(tasks.size());
+        WorkStealingQueues queues(numThreads);
+        for(size_t i = 0; i < tasks.size(); i++) {
+            queues.push(static_cast<int>(i % numThreads), static_cast<int>(i));
+        }
+
+        auto worker = [&](int thread) {
+            while(const std::optional<int> index = queues.pop(thread)) {
+                // every task plays its path out on a fresh copy of the position; a Game is a memcpy to copy, so the
+                // path is never unmade and its saved states are dropped
+                const PerftTask& task = tasks[*index];
+                Game local = game;
+                StateInfo saved;
+                for(int i = 0; i < task.pathLength; i++) {
+                    local.makeMove(task.path[i], saved);
+                }
+                const int remainingDepth = depth - task.pathLength;
+                // each task writes only its own slot, so counts needs no lock
+                counts[*index] = table != nullptr ? Perft::perftHashed(local, remainingDepth, *table) : Perft::perftBulk(local, remainingDepth);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for(int thread = 1; thread < numThreads; thread++) {
+            threads.emplace_back(worker, thread);
+        }
+        worker(0);
+        for(std::thread& thread : threads) {
+            thread.join();
+        }
+        return counts;
+    }
+} // namespace
+
+// limit of 18,446,744,073,709,551,615
+uint64_t Perft::perft(Game& game, int depth) {
+    return game.sideToMove() == Color::White ? perft_<Color::White, false>(game, depth) : perft_<Color::Black, false>(game, depth);
+}
+
+uint64_t Perft::perftBulk(Game& game, int depth) {
+    return game.sideToMove() == Color::White ? perft_<Color::White, true>(game, depth) : perft_<Color::Black, true>(game, depth);
+}
+
+uint64_t Perft::perftHashed(Game& game, int depth, PerftTable& table) {
+    return game.sideToMove() == Color::White ? perftHashed_<Color::White>(game, depth, table) : perftHashed_<Color::Black>(game, depth, table);
 }
 
 
+uint64_t Perft::perftParallel(Game& game, int depth, int numThreads, PerftTable* table) {
+    if (depth <= 1 || numThreads <= 1) {
+        return table != nullptr ? perftHashed(game, depth, *table) : perftBulk(game, depth);
+    }
+
+    const std::vector<PerftTask> tasks = splitTasks_(game, depth, numThreads);
+    uint64_t numPositions = 0;
+    for (const uint64_t count : countTasks_(game, depth, tasks, numThreads, table)) {
+        numPositions += count;
+    }
+    return numPositions;
+}
+
 // Prints each root move and its subtree count; matches Stockfish for debugging
-uint64_t Perft::perftDivide(Game& game, int depth) {
+uint64_t Perft::perftDivide(Game& game, int depth, int numThreads) {
     if (depth <= 0) {
         return 1;
     }
 
+    if (numThreads > 1) {
+        MoveList rootMoves;
+        game.generateLegalMoves(rootMoves);
+        const std::vector<PerftTask> tasks = splitTasks_(game, depth, numThreads);
+        const std::vector<uint64_t> counts = countTasks_(game, depth, tasks, numThreads, nullptr);
+
+        std::vector<uint64_t> rootCounts(rootMoves.size, 0);
+        for (size_t i = 0; i < tasks.size(); i++) {
+            rootCounts[tasks[i].rootIndex] += counts[i];
+        }
+
+        uint64_t numPositions = 0;
+        for (int i = 0; i < rootMoves.size; i++) {
+            std::cerr << rootMoves.data[i].toLongAlgebraic() << ": " << rootCounts[i] << "\n";
+            numPositions += rootCounts[i];
+        }
+        return numPositions;
+    }
+
     uint64_t numPositions = 0;
     MoveList moves;
-    game.generatePseudoLegalMoves(moves);
+    game.generateLegalMoves(moves);
 
+    StateInfo saved;
     for (int i = 0; i < moves.size; i++) {
         const Move& move = moves.data[i];
-        const UndoInfo undoInfo = game.getUndoInfo(game.mailbox()[move.targetSquare()]);
-
-        game.makeMove(move);
 
-        if(game.doesMovePutUsInCheck(move)) {
-            game.undoMove(move, undoInfo);
-            continue;
-        }
+        game.makeMove(move, saved);
 
-        // no checks, we can continue recursing
+        // every move is legal, we can continue recursing
         const uint64_t moveNodes = perft(game, depth - 1);
 
-        game.undoMove(move, undoInfo);
+        game.unmakeMove(move, saved);
 
         std::cerr << move.toLongAlgebraic() << ": " << moveNodes << "\n";
 
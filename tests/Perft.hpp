@@ -1,11 +1,23 @@
 #include <cstdint>
 
 #include "../src/game/Game.hpp"
+#include "PerftTable.hpp"
 
 // See https://www.chessprogramming.org/Perft for more information
 // collection of perft-related helpers for testing
 class Perft{
 public:
+    // Count leaf positions by making every move down to depth 0.
     static uint64_t perft(Game& game, int depth);
-    static uint64_t perftDivide(Game& game, int depth);
+    // Count leaf positions like perft, but count the legal moves at depth 1 instead of making them. Much faster.
+    static uint64_t perftBulk(Game& game, int depth);
+    // Count leaf positions like perftBulk, reusing the counts of transpositions cached in table.
+    static uint64_t perftHashed(Game& game, int depth, PerftTable& table);
+    // Count leaf positions like perftBulk, or like perftHashed if given a table, on numThreads threads. The tree is split
+    // at the root, or a ply further down if the root has too few moves to keep every thread busy; each thread plays
+    // the split off subtrees on its own copy of game and steals from the others once it runs out.
+    static uint64_t perftParallel(Game& game, int depth, int numThreads, PerftTable* table = nullptr);
+    // Print every root move's leaf count, in the format of Stockfish's "go perft", and return the total. With more than
+    // one thread, the root moves are counted in parallel and printed in the same order once all are done.
+    static uint64_t perftDivide(Game& game, int depth, int numThreads = 1);
 };
\ No newline at end of file
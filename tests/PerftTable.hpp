@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Transposition table for perft: caches the leaf count of a position at a depth, keyed by the position's Zobrist key.
+//
+// Lock-free, so threads may share one table. Each entry is two independently written words, the packed data and the
+// key XOR the data; a torn write from two racing threads fails the XOR check and reads as a miss instead of a wrong
+// count. See https://www.chessprogramming.org/Shared_Hash_Table#Lockless
+//
+// Each bucket has a depth-preferred slot, which only a deeper (or equally deep) entry replaces, and an always-replace
+// slot for everything else. Deep entries save the most work, so they are the ones worth keeping.
+class PerftTable {
+public:
+    // Allocate a table of about the given size, rounded down to a power of two buckets. Entries start empty.
+    explicit PerftTable(size_t megabytes) {
+        constexpr size_t BYTES_PER_MEGABYTE = 1024 * 1024;
+        const size_t maxBuckets = std::max<size_t>(1, megabytes * BYTES_PER_MEGABYTE / sizeof(Bucket_));
+        size_t numBuckets = 1;
+        while(numBuckets * 2 <= maxBuckets) {
+            numBuckets *= 2;
+        }
+        buckets_ = std::make_unique<Bucket_[]>(numBuckets);
+        mask_ = numBuckets - 1;
+    }
+
+    // If the count of the position with key at depth is cached, write it to count.
+    bool probe(uint64_t key, int depth, uint64_t& count) const noexcept {
+        const Bucket_& bucket = buckets_[key & mask_];
+        for(const Entry_& entry : bucket.entries) {
+            const uint64_t data = entry.data.load(std::memory_order_relaxed);
+            const uint64_t check = entry.check.load(std::memory_order_relaxed);
+            if((check ^ data) == key && depthOf_(data) == depth) {
+                count = countOf_(data);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Cache the count of the position with key at depth.
+    void store(uint64_t key, int depth, uint64_t count) noexcept {
+        Bucket_& bucket = buckets_[key & mask_];
+        const uint64_t data = pack_(depth, count);
+
+        Entry_& deepest = bucket.entries[0];
+        const uint64_t deepestData = deepest.data.load(std::memory_order_relaxed);
+        Entry_& target = depth >= depthOf_(deepestData) ? deepest : bucket.entries[1];
+        target.data.store(data, std::memory_order_relaxed);
+        target.check.store(key ^ data, std::memory_order_relaxed);
+    }
+
+    // Empty every entry. Not safe while other threads use the table.
+    void clear() noexcept {
+        for(size_t i = 0; i <= mask_; i++) {
+            for(Entry_& entry : buckets_[i].entries) {
+                entry.data.store(0, std::memory_order_relaxed);
+                entry.check.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    // The count takes the low 56 bits of the data word, the depth the high 8.
+    static constexpr int COUNT_BITS = 56;
+    static constexpr uint64_t COUNT_MASK = (1ULL << COUNT_BITS) - 1;
+
+    struct Entry_ {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> data{0};
+    };
+    // Two entries, 32 bytes; two buckets share a cache line.
+    struct Bucket_ {
+        Entry_ entries[2]; // NOLINT(cppcoreguidelines-avoid-c-arrays, modernize-avoid-c-arrays) fixed bucket layout
+    };
+
+    static constexpr uint64_t pack_(int depth, uint64_t count) noexcept {
+        return (static_cast<uint64_t>(depth) << COUNT_BITS) | (count & COUNT_MASK);
+    }
+    static constexpr int depthOf_(uint64_t data) noexcept { return static_cast<int>(data >> COUNT_BITS); }
+    static constexpr uint64_t countOf_(uint64_t data) noexcept { return data & COUNT_MASK; }
+
+    std::unique_ptr<Bucket_[]> buckets_; // NOLINT(cppcoreguidelines-avoid-c-arrays, modernize-avoid-c-arrays) atomics can not live in a vector
+    size_t mask_{0};
+};
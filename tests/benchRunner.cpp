@@ -0,0 +1,294 @@
+// Runs each benchmark workload many times, pinned to one core where the platform allows, and summarizes its NPS by
+// the median and a 95% confidence interval of the median. Results can be written as JSON and compared against a
+// baseline written by an earlier run; a median NPS drop beyond the threshold is flagged and fails the run.
+//
+// Usage: benchRunner [--runs N] [--workload perft|search]... [--cpu N] [--output FILE] [--baseline FILE]
+//                    [--threshold PERCENT]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include "../src/engine/Bench.hpp"
+#include "Perft.hpp"
+#include "PerftPositions.hpp"
+
+namespace {
+    struct Options {
+        int runs{10}; // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+        std::vector<std::string> workloads;
+        // Core to pin to; the core the runner starts on if not given.
+        std::optional<int> cpu;
+        std::string outputPath;
+        std::string baselinePath;
+        // Largest median NPS drop, in percent, that is not flagged.
+        double thresholdPercent{3.0}; // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+    };
+
+    // A fixed amount of work; returns the nodes it visited, which must be the same on every run.
+    struct Workload {
+        std::string name;
+        std::function<uint64_t()> run;
+    };
+
+    // Summary of one workload's runs.
+    struct WorkloadResult {
+        std::string name;
+        uint64_t nodes{0};
+        double medianNps{0};
+        double ciLowNps{0};
+        double ciHighNps{0};
+        std::vector<double> samplesNps;
+    };
+
+    // Parse the command line. Throws on unknown or malformed arguments.
+    Options parseOptions(int argc, char** argv) {
+        Options options;
+        const std::vector<std::string> args(argv + 1, argv + argc);
+        for(size_t i = 0; i < args.size(); i++) {
+            const bool hasValue = i + 1 < args.size();
+            if(args[i] == "--runs" && hasValue) {
+                options.runs = std::max(1, std::stoi(args[++i]));
+            } else if(args[i] == "--workload" && hasValue) {
+                options.workloads.push_back(args[++i]);
+            } else if(args[i] == "--cpu" && hasValue) {
+                options.cpu = std::stoi(args[++i]);
+#if defined(__linux__)
+                if(*options.cpu < 0 || *options.cpu >= CPU_SETSIZE) {
+                    std::cerr << "--cpu must be between 0 and " << CPU_SETSIZE - 1 << ", got " << *options.cpu << "\n";
+                    throw std::runtime_error("Invalid arguments.");
+                }
+#endif
+            } else if(args[i] == "--output" && hasValue) {
+                options.outputPath = args[++i];
+            } else if(args[i] == "--baseline" && hasValue) {
+                options.baselinePath = args[++i];
+            } else if(args[i] == "--threshold" && hasValue) {
+                options.thresholdPercent = std::stod(args[++i]);
+            } else {
+                std::cerr << "Unknown argument: " << args[i] << "\n";
+                throw std::runtime_error("Invalid arguments.");
+            }
+        }
+        return options;
+    }
+
+    // Every workload the runner knows; both are deterministic, so their node counts double as a behavior check.
+    std::vector<Workload> allWorkloads() {
+        return {
+            // Bulk perft of every known position, to the deepest depth of at most ten million leaves
+            {"perft", []() {
+                constexpr uint64_t MAX_LEAVES = 10'000'000;
+                uint64_t nodes = 0;
+                for(const PerftPosition& position : PERFT_POSITIONS) {
+                    int depth = 1;
+                    while(depth + 1 < static_cast<int>(position.perfts.size()) && position.perfts[depth + 1] <= MAX_LEAVES) {
+                        depth++;
+                    }
+                    Game game;
+                    game.loadFEN(position.FEN);
+                    nodes += Perft::perftBulk(game, depth);
+                }
+                return nodes;
+            }},
+            // The engine bench one ply shallower than chess bench, to keep many runs affordable
+            {"search", []() {
+                return Bench::run(Bench::DEFAULT_DEPTH - 1, false).nodes;
+            }},
+        };
+    }
+
+    // Pin the process to one core, so runs do not migrate between cores or land on a slower one. Best effort.
+    void pinToCpu(std::optional<int> cpu) {
+#if defined(__linux__)
+        // sched_getcpu returns -1 on failure; CPU_SET must only see cores a cpu_set_t holds
+        const int target = cpu.value_or(sched_getcpu());
+        if(target < 0 || target >= CPU_SETSIZE) {
+            std::cerr << "Unable to pin to cpu " << target << "; running unpinned\n";
+            return;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(target, &set);
+        if(sched_setaffinity(0, sizeof(set), &set) != 0) {
+            std::cerr << "Unable to pin to cpu " << target << "; running unpinned\n";
+            return;
+        }
+        std::cerr << "Pinned to cpu " << target << "\n";
+#else
+        (void)cpu;
+        std::cerr << "Pinning is not supported on this platform; running unpinned\n";
+#endif
+    }
+
+    // Time runs of workload after one warm-up run, and summarize them.
+    WorkloadResult measure(const Workload& workload, int runs) {
+        WorkloadResult result;
+        result.name = workload.name;
+        result.nodes = workload.run();
+
+        for(int run = 0; run < runs; run++) {
+            const auto start = std::chrono::steady_clock::now();
+            const uint64_t nodes = workload.run();
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if(nodes != result.nodes) {
+                std::cerr << workload.name << ": visited " << result.nodes << " nodes, then " << nodes << "; the workload is not deterministic\n";
+                throw std::runtime_error("Nondeterministic workload.");
+            }
+            result.samplesNps.push_back(static_cast<double>(nodes) / seconds);
+            std::cerr << workload.name << ": run " << run + 1 << "/" << runs << ": " << static_cast<uint64_t>(result.samplesNps.back()) << " nps\n";
+        }
+
+        // Distribution free 95% interval of the median: the order statistics whose ranks are 1.96 standard deviations of
+        // a Binomial(n, 1/2) either side of the middle. Holds for any distribution of timings, unlike a mean +- t * s.
+        std::vector<double> sorted = result.samplesNps;
+        std::sort(sorted.begin(), sorted.end());
+        const auto count = static_cast<double>(sorted.size());
+        const size_t middle = sorted.size() / 2;
+        result.medianNps = sorted.size() % 2 == 1 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+        constexpr double Z_95 = 1.96;
+        const double spread = Z_95 * std::sqrt(count) / 2;
+        const auto lowRank = static_cast<size_t>(std::max(0.0, std::floor(count / 2 - spread)));
+        const auto highRank = static_cast<size_t>(std::min(count - 1, std::ceil(count / 2 + spread)));
+        result.ciLowNps = sorted[lowRank];
+        result.ciHighNps = sorted[highRank];
+        return result;
+    }
+
+    // One workload per line, so that readBaseline can read it back without a JSON library.
+    void writeJson(std::ostream& out, const std::vector<WorkloadResult>& results, int runs) {
+        out << std::fixed << std::setprecision(0);
+        out << "{\n  \"runs\": " << runs << ",\n  \"workloads\": [\n";
+        for(size_t i = 0; i < results.size(); i++) {
+            const WorkloadResult& result = results[i];
+            out << "    {\"name\": \"" << result.name << "\", \"nodes\": " << result.nodes << ", \"median_nps\": " << result.medianNps
+                << ", \"ci_low_nps\": " << result.ciLowNps << ", \"ci_high_nps\": " << result.ciHighNps << ", \"samples_nps\": [";
+            for(size_t sample = 0; sample < result.samplesNps.size(); sample++) {
+                out << (sample > 0 ? ", " : "") << result.samplesNps[sample];
+            }
+            out << "]}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+
+    // Number after "key": in line, if there is one.
+    std::optional<double> jsonNumber(const std::string& line, const std::string& key) {
+        const size_t keyStart = line.find("\"" + key + "\": ");
+        if(keyStart == std::string::npos) {
+            return std::nullopt;
+        }
+        std::istringstream stream(line.substr(keyStart + key.size() + 4)); // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers) quotes, colon, space
+        double value = 0;
+        if(!(stream >> value)) {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    // Read the workload lines of a file written by writeJson.
+    std::vector<WorkloadResult> readBaseline(const std::string& path) {
+        std::ifstream file(path);
+        if(!file) {
+            std::cerr << "Unable to open baseline: " << path << "\n";
+            throw std::runtime_error("Invalid baseline.");
+        }
+
+        std::vector<WorkloadResult> baseline;
+        std::string line;
+        const std::string nameKey = "{\"name\": \"";
+        while(std::getline(file, line)) {
+            const size_t nameStart = line.find(nameKey);
+            if(nameStart == std::string::npos) {
+                continue;
+            }
+            WorkloadResult result;
+            const size_t nameEnd = line.find('"', nameStart + nameKey.size());
+            result.name = line.substr(nameStart + nameKey.size(), nameEnd - nameStart - nameKey.size());
+            result.nodes = static_cast<uint64_t>(jsonNumber(line, "nodes").value_or(0));
+            result.medianNps = jsonNumber(line, "median_nps").value_or(0);
+            result.ciLowNps = jsonNumber(line, "ci_low_nps").value_or(0);
+            result.ciHighNps = jsonNumber(line, "ci_high_nps").value_or(0);
+            baseline.push_back(result);
+        }
+        return baseline;
+    }
+
+    // Print each result against its baseline. Returns false if any median dropped by more than thresholdPercent.
+    bool compare(const std::vector<WorkloadResult>& results, const std::vector<WorkloadResult>& baseline, double thresholdPercent) {
+        constexpr double PERCENT = 100;
+        bool passed = true;
+        std::cout << std::fixed << std::setprecision(2);
+        for(const WorkloadResult& result : results) {
+            const auto before = std::find_if(baseline.begin(), baseline.end(), [&](const WorkloadResult& entry) { return entry.name == result.name; });
+            if(before == baseline.end() || before->medianNps <= 0) {
+                std::cout << result.name << ": not in the baseline\n";
+                continue;
+            }
+
+            const double changePercent = (result.medianNps / before->medianNps - 1) * PERCENT;
+            // Disjoint intervals mean the change is unlikely to be noise
+            const bool significant = result.ciHighNps < before->ciLowNps || result.ciLowNps > before->ciHighNps;
+            const bool regressed = changePercent < -thresholdPercent;
+            passed = passed && !regressed;
+            std::cout << result.name << ": " << std::showpos << changePercent << std::noshowpos << "% median NPS"
+                << (significant ? ", outside the noise" : ", within the noise") << (regressed ? " REGRESSION" : "") << "\n";
+            if(before->nodes != result.nodes) {
+                std::cout << result.name << ": node count changed from " << before->nodes << " to " << result.nodes << "; the change is not a pure speedup\n";
+            }
+        }
+        return passed;
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    const Options options = parseOptions(argc, argv);
+    std::vector<Workload> workloads = allWorkloads();
+    if(!options.workloads.empty()) {
+        for(const std::string& name : options.workloads) {
+            if(std::none_of(workloads.begin(), workloads.end(), [&](const Workload& workload) { return workload.name == name; })) {
+                std::cerr << "Unknown workload: " << name << "\n";
+                throw std::runtime_error("Invalid arguments.");
+            }
+        }
+        workloads.erase(std::remove_if(workloads.begin(), workloads.end(), [&](const Workload& workload) {
+            return std::find(options.workloads.begin(), options.workloads.end(), workload.name) == options.workloads.end();
+        }), workloads.end());
+    }
+
+    pinToCpu(options.cpu);
+
+    std::vector<WorkloadResult> results;
+    for(const Workload& workload : workloads) {
+        results.push_back(measure(workload, options.runs));
+    }
+
+    for(const WorkloadResult& result : results) {
+        std::cout << std::fixed << std::setprecision(0) << result.name << ": " << result.nodes << " nodes, median " << result.medianNps
+            << " nps, 95% CI [" << result.ciLowNps << ", " << result.ciHighNps << "] over " << options.runs << " runs\n";
+    }
+
+    if(!options.outputPath.empty()) {
+        std::ofstream output(options.outputPath);
+        writeJson(output, results, options.runs);
+    }
+
+    if(!options.baselinePath.empty() && !compare(results, readBaseline(options.baselinePath), options.thresholdPercent)) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
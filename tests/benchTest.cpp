@@ -0,0 +1,20 @@
+#include <cstdlib>
+#include <iostream>
+
+#include "../src/engine/Bench.hpp"
+
+// Runs the bench twice; the node signature is only useful if a second run reproduces it exactly.
+int main() {
+    // shallow, so the test stays quick; the determinism does not depend on the depth
+    constexpr int DEPTH = 3;
+
+    const Bench::BenchResult first = Bench::run(DEPTH);
+    const Bench::BenchResult second = Bench::run(DEPTH);
+    if(first.nodes != second.nodes) {
+        std::cerr << "Bench signature changed between runs: " << first.nodes << " then " << second.nodes << "\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cerr << "Bench signature at depth " << DEPTH << ": " << first.nodes << " nodes, ok\n";
+    return EXIT_SUCCESS;
+}
@@ -51,6 +51,7 @@ void runEngineSelfPlayTest(int maxPlies) {
         std::cerr << "Ply " << ply << " (" << sideChar << "): "
                   << moveString
                   << "   eval=" << eval
+                  << "   depth=" << stats.depth
                   << "   think_ms=" << thinkMs << "\n";
 
         ply++;
@@ -62,7 +63,7 @@ void runEngineSelfPlayTest(int maxPlies) {
     std::cerr << "\nSelf-play finished after " << ply << " plies. Total time: " << totalMs << " ms\n";
 
     if (game.isFinished()) {
-        if (game.isInCheck(game.sideToMove())) {
+        if (game.inCheck()) {
             std::cerr << "Result: checkmate. Side to move is checkmated.\n";
         } else {
             std::cerr << "Result: draw / stalemate / insufficient material (game reports finished).\n";
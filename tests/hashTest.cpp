@@ -0,0 +1,120 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/game/Game.hpp"
+
+// Checks the incremental Zobrist key against a from-scratch key, and that it tells apart what it should.
+
+// Walk every position up to depth; after every make and undo the incremental key must match the recomputed key.
+bool checkIncrementalHash(Game& game, int depth) { // NOLINT(misc-no-recursion)
+    if(game.hash() != game.computeHash()) {
+        std::cerr << "Incremental hash " << game.hash() << " does not match computed hash " << game.computeHash() << "\n" << game.to_string() << "\n";
+        return false;
+    }
+    if(depth <= 0) {
+        return true;
+    }
+
+    // a null move must keep the key incremental too, and undoing it must restore the key
+    if(!game.inCheck()) {
+        const uint64_t hashBefore = game.hash();
+        StateInfo saved;
+        game.makeNullMove(saved);
+        const bool ok = game.hash() == game.computeHash() && game.hash() != hashBefore;
+        game.undoNullMove(saved);
+        if(!ok || game.hash() != hashBefore) {
+            std::cerr << "Null move did not keep the hash\n" << game.to_string() << "\n";
+            return false;
+        }
+    }
+
+    MoveList moves;
+    game.generateLegalMoves(moves);
+    StateInfo saved;
+    for(int i = 0; i < moves.size; i++) {
+        const Move move = moves.data[i];
+        const uint64_t hashBefore = game.hash();
+
+        game.makeMove(move, saved);
+        const bool ok = checkIncrementalHash(game, depth - 1);
+        game.unmakeMove(move, saved);
+
+        if(!ok) {
+            return false;
+        }
+        if(game.hash() != hashBefore) {
+            std::cerr << "Undoing " << move.toLongAlgebraic() << " did not restore the hash\n" << game.to_string() << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Play moves given in long algebraic notation, e.g., "e2e4".
+void playMoves(Game& game, const std::vector<std::string>& moves) {
+    for(const std::string& moveString : moves) {
+        MoveList legalMoves;
+        game.generateLegalMoves(legalMoves);
+        for(int i = 0; i < legalMoves.size; i++) {
+            if(legalMoves.data[i].toLongAlgebraic() == moveString) {
+                // the moves are never unmade, so the saved state is dropped
+                StateInfo saved;
+                game.makeMove(legalMoves.data[i], saved);
+                break;
+            }
+        }
+    }
+}
+
+uint64_t hashOfFEN(const std::string& FEN) {
+    Game game;
+    game.loadFEN(FEN);
+    return game.hash();
+}
+
+int main() {
+    for(const std::string& FEN : {
+        std::string{Utils::STARTING_FEN},
+        std::string{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -"},
+        std::string{"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"},
+        std::string{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"}
+    }) {
+        Game game;
+        game.loadFEN(FEN);
+        if(!checkIncrementalHash(game, 3)) {
+            return EXIT_FAILURE;
+        }
+    }
+    std::cerr << "Incremental hash: ok\n";
+
+    // different move orders reaching the same position must share a key
+    Game first;
+    first.loadFEN(std::string{Utils::STARTING_FEN});
+    playMoves(first, {"g1f3", "g8f6", "b1c3", "b8c6"});
+    Game second;
+    second.loadFEN(std::string{Utils::STARTING_FEN});
+    playMoves(second, {"b1c3", "b8c6", "g1f3", "g8f6"});
+    if(first.hash() != second.hash()) {
+        std::cerr << "Transposition: keys differ\n";
+        return EXIT_FAILURE;
+    }
+    std::cerr << "Transposition: ok\n";
+
+    // side to move, castling rights, and en passant square are all part of the key
+    const std::string placement = "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR";
+    const uint64_t base = hashOfFEN(placement + " b KQkq - 0 1");
+    if(
+        base == hashOfFEN(placement + " w KQkq - 0 1") ||
+        base == hashOfFEN(placement + " b Kkq - 0 1") ||
+        base == hashOfFEN(placement + " b KQkq e3 0 1")
+    ) {
+        std::cerr << "Flags: a flag does not change the key\n";
+        return EXIT_FAILURE;
+    }
+    std::cerr << "Flags: ok\n";
+
+    return EXIT_SUCCESS;
+}
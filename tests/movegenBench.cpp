@@ -0,0 +1,203 @@
+// Times the move generation primitives one at a time over a fixed suite of positions, instead of the whole engine.
+// Each benchmark is warmed up, sized to take at least --min-time-ms per repetition, and repeated; the summary has the
+// median, min, and standard deviation of the time per operation.
+//
+// Usage: movegenBench [--repetitions N] [--min-time-ms N]
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../src/game/Game.hpp"
+#include "../src/game/Move.hpp"
+#include "../src/game/Utils.hpp"
+
+namespace {
+    struct BenchPosition {
+        std::string_view phase;
+        std::string_view FEN;
+    };
+
+    // Opening, middlegame, endgame, and promotion heavy positions, so no single kind of position dominates the timings.
+    constexpr std::array<BenchPosition, 12> POSITIONS{{ // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+        {"opening", Utils::STARTING_FEN},
+        {"opening", "r1bqkbnr/pppp1ppp/2n5/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 3 3"},
+        {"opening", "rnbqkb1r/pp2pppp/3p1n2/8/3NP3/8/PPP2PPP/RNBQKB1R w KQkq - 1 5"},
+        {"middlegame", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"},
+        {"middlegame", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"},
+        {"middlegame", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"},
+        {"endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"},
+        {"endgame", "8/8/4k3/3p4/3P1K2/8/5R2/8 w - - 0 40"},
+        {"endgame", "6k1/5ppp/8/8/8/8/1r3PPP/4R1K1 b - - 0 30"},
+        {"promotion", "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N w - - 0 1"},
+        {"promotion", "8/PPP4k/8/8/8/8/4Kppp/8 b - - 0 1"},
+        {"promotion", "r3k3/1P6/8/8/8/8/1p6/R3K3 w Qq - 0 1"},
+    }};
+
+    struct Options {
+        int repetitions{15}; // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+        int minTimeMs{50}; // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+    };
+
+    // Parse the command line. Throws on unknown or malformed arguments.
+    Options parseOptions(int argc, char** argv) {
+        Options options;
+        const std::vector<std::string> args(argv + 1, argv + argc);
+        for(size_t i = 0; i < args.size(); i++) {
+            const bool hasValue = i + 1 < args.size();
+            if(args[i] == "--repetitions" && hasValue) {
+                options.repetitions = std::max(1, std::stoi(args[++i]));
+            } else if(args[i] == "--min-time-ms" && hasValue) {
+                options.minTimeMs = std::max(1, std::stoi(args[++i]));
+            } else {
+                std::cerr << "Unknown argument: " << args[i] << "\n";
+                throw std::runtime_error("Invalid arguments.");
+            }
+        }
+        return options;
+    }
+
+    // Results of every benchmark are folded in here and printed, so the compiler can not drop the work.
+    uint64_t sink = 0;
+
+    struct Summary {
+        double medianNs{0};
+        double minNs{0};
+        double stddevNs{0};
+    };
+
+    Summary summarize(std::vector<double> nsPerOp) {
+        std::sort(nsPerOp.begin(), nsPerOp.end());
+        const size_t middle = nsPerOp.size() / 2;
+        Summary summary;
+        summary.medianNs = nsPerOp.size() % 2 == 1 ? nsPerOp[middle] : (nsPerOp[middle - 1] + nsPerOp[middle]) / 2;
+        summary.minNs = nsPerOp.front();
+
+        double mean = 0;
+        for(const double sample : nsPerOp) {
+            mean += sample;
+        }
+        mean /= static_cast<double>(nsPerOp.size());
+        double variance = 0;
+        for(const double sample : nsPerOp) {
+            variance += (sample - mean) * (sample - mean);
+        }
+        summary.stddevNs = std::sqrt(variance / static_cast<double>(nsPerOp.size()));
+        return summary;
+    }
+
+    // Time round, which runs the benchmark once over every position and returns how many operations it did. Rounds
+    // are doubled until a repetition takes minTimeMs, which also warms up the caches and branch predictors.
+    template<typename Round>
+    void runBenchmark(std::string_view name, const Options& options, Round round) {
+        using Clock = std::chrono::steady_clock;
+        const auto timeRounds = [&](int rounds, uint64_t& ops) {
+            ops = 0;
+            const auto start = Clock::now();
+            for(int i = 0; i < rounds; i++) {
+                ops += round();
+            }
+            return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        };
+
+        const double minTimeNs = options.minTimeMs * 1e6; // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers) ms to ns
+        int rounds = 1;
+        uint64_t ops = 0;
+        while(timeRounds(rounds, ops) < minTimeNs) {
+            rounds *= 2;
+        }
+
+        std::vector<double> nsPerOp;
+        for(int repetition = 0; repetition < options.repetitions; repetition++) {
+            const double ns = timeRounds(rounds, ops);
+            nsPerOp.push_back(ns / static_cast<double>(ops));
+        }
+
+        const Summary summary = summarize(nsPerOp);
+        constexpr double NS_PER_SECOND = 1e9;
+        std::cout << std::left << std::setw(26) << name << std::right << std::fixed << std::setprecision(2) // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+            << std::setw(12) << summary.medianNs << std::setw(12) << summary.minNs << std::setw(12) << summary.stddevNs // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+            << std::setw(16) << std::setprecision(0) << NS_PER_SECOND / summary.medianNs << "\n"; // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    const Options options = parseOptions(argc, argv);
+
+    std::vector<Game> games(POSITIONS.size());
+    std::vector<MoveList> legalMoves(POSITIONS.size());
+    for(size_t i = 0; i < POSITIONS.size(); i++) {
+        games[i].loadFEN(POSITIONS[i].FEN);
+        games[i].generateLegalMoves(legalMoves[i]);
+    }
+
+    std::cout << POSITIONS.size() << " positions, " << options.repetitions << " repetitions of at least " << options.minTimeMs << " ms\n";
+    std::cout << std::left << std::setw(26) << "benchmark" << std::right << std::setw(12) << "median ns" << std::setw(12) << "min ns" // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+        << std::setw(12) << "stddev ns" << std::setw(16) << "ops/s" << "\n"; // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+    runBenchmark("generatePseudoLegalMoves", options, [&]() {
+        MoveList moves;
+        for(const Game& game : games) {
+            game.generatePseudoLegalMoves(moves);
+            sink += moves.size;
+            moves.clear();
+        }
+        return static_cast<uint64_t>(games.size());
+    });
+
+    runBenchmark("generateLegalMoves", options, [&]() {
+        MoveList moves;
+        for(const Game& game : games) {
+            game.generateLegalMoves(moves);
+            sink += moves.size;
+            moves.clear();
+        }
+        return static_cast<uint64_t>(games.size());
+    });
+
+    // One operation is a makeMove and unmakeMove pair.
+    runBenchmark("makeMove + unmakeMove", options, [&]() {
+        uint64_t ops = 0;
+        for(size_t i = 0; i < games.size(); i++) {
+            Game& game = games[i];
+            const MoveList& moves = legalMoves[i];
+            StateInfo saved;
+            for(int move = 0; move < moves.size; move++) {
+                game.makeMove(moves.data[move], saved);
+                sink += game.hash();
+                game.unmakeMove(moves.data[move], saved);
+            }
+            ops += moves.size;
+        }
+        return ops;
+    });
+
+    // One operation is one square; every square is asked about the side that is not to move.
+    runBenchmark("isSquareAttacked", options, [&]() {
+        for(const Game& game : games) {
+            const Color attacker = Game::oppositeColor(game.sideToMove());
+            for(int square = 0; square < Utils::NUM_SQUARES; square++) {
+                sink += static_cast<uint64_t>(game.isSquareAttacked(square, attacker));
+            }
+        }
+        return static_cast<uint64_t>(games.size()) * Utils::NUM_SQUARES;
+    });
+
+    // Finds the king and its attackers from scratch, unlike inCheck, which reads the checkers found by makeMove.
+    runBenchmark("isInCheck", options, [&]() {
+        for(const Game& game : games) {
+            sink += static_cast<uint64_t>(game.isInCheck(game.sideToMove()));
+        }
+        return static_cast<uint64_t>(games.size());
+    });
+
+    std::cerr << "checksum: " << sink << "\n";
+}
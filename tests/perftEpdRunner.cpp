@@ -0,0 +1,245 @@
+// Checks the perft counts of every position in an EPD file, with lines of the form
+//     <FEN> ;D1 20 ;D2 400 ;D3 8902
+// The file is streamed in fixed size chunks and every chunk's positions are checked on all cores, so corpora of any
+// size run in constant memory. Lines are parsed in place without allocating. Prints every mismatch and a summary
+// with the aggregate NPS and hardware counters per node where available; exits non-zero on any mismatch.
+//
+// Usage: perftEpdRunner <file.epd> [--threads N] [--max-nodes N]
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../src/engine/PerfCounters.hpp"
+#include "Perft.hpp"
+
+namespace {
+    // Deepest depth an EPD line may list.
+    constexpr int MAX_EPD_DEPTH = 15;
+    // Bytes read from the file at a time; also the longest line allowed.
+    constexpr size_t CHUNK_BYTES = 1 << 20;
+
+    // One parsed EPD line. The FEN points into the chunk buffer, so it is only valid until the next chunk is read.
+    struct EpdEntry {
+        std::string_view FEN;
+        // Expected count at each depth; empty if the line does not list the depth. A count of 0 is a real count, e.g., of
+        // a mate or stalemate at depth 1.
+        std::array<std::optional<uint64_t>, MAX_EPD_DEPTH + 1> expected{};
+        size_t lineNumber{0};
+    };
+
+    struct Options {
+        std::string path;
+        int numThreads{std::max(1, static_cast<int>(std::thread::hardware_concurrency()))};
+        // Depths whose expected count is larger are skipped.
+        uint64_t maxNodes{10'000'000}; // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers) keeps a large corpus to minutes
+    };
+
+    // Totals over every checked position, shared by the worker threads.
+    struct Totals {
+        std::atomic<uint64_t> positions{0};
+        std::atomic<uint64_t> depths{0};
+        std::atomic<uint64_t> nodes{0};
+        std::atomic<uint64_t> failures{0};
+    };
+
+    // Parse the command line. Throws on unknown or malformed arguments.
+    Options parseOptions(int argc, char** argv) {
+        Options options;
+        const std::vector<std::string> args(argv + 1, argv + argc);
+        for(size_t i = 0; i < args.size(); i++) {
+            const bool hasValue = i + 1 < args.size();
+            if(args[i] == "--threads" && hasValue) {
+                options.numThreads = std::max(1, std::stoi(args[++i]));
+            } else if(args[i] == "--max-nodes" && hasValue) {
+                options.maxNodes = std::stoull(args[++i]);
+            } else if(options.path.empty() && args[i].rfind("--", 0) != 0) {
+                options.path = args[i];
+            } else {
+                std::cerr << "Unknown argument: " << args[i] << "\n";
+                throw std::runtime_error("Invalid arguments.");
+            }
+        }
+        if(options.path.empty()) {
+            std::cerr << "Usage: perftEpdRunner <file.epd> [--threads N] [--max-nodes N]\n";
+            throw std::runtime_error("Invalid arguments.");
+        }
+        return options;
+    }
+
+    std::string_view trim(std::string_view text) {
+        const size_t first = text.find_first_not_of(" \t\r");
+        if(first == std::string_view::npos) {
+            return {};
+        }
+        return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+    }
+
+    // Parse one line into entry. Returns false for blank lines and comments; throws on malformed depth fields.
+    bool parseLine(std::string_view line, size_t lineNumber, EpdEntry& entry) {
+        line = trim(line);
+        if(line.empty() || line.front() == '#') {
+            return false;
+        }
+
+        entry.expected.fill(std::nullopt);
+        entry.lineNumber = lineNumber;
+        size_t fieldEnd = line.find(';');
+        entry.FEN = trim(line.substr(0, fieldEnd));
+        while(fieldEnd != std::string_view::npos) {
+            const size_t fieldStart = fieldEnd + 1;
+            fieldEnd = line.find(';', fieldStart);
+            const std::string_view field = trim(line.substr(fieldStart, fieldEnd == std::string_view::npos ? std::string_view::npos : fieldEnd - fieldStart));
+
+            // Each field is "D<depth> <count>"
+            int depth = 0;
+            uint64_t count = 0;
+            const char* const end = field.data() + field.size();
+            const auto [depthEnd, depthError] = std::from_chars(field.data() + std::min<size_t>(1, field.size()), end, depth);
+            const auto [countEnd, countError] = std::from_chars(std::min(depthEnd + 1, end), end, count);
+            if(field.empty() || field.front() != 'D' || depthError != std::errc{} || depth < 1 || depth > MAX_EPD_DEPTH
+                || depthEnd == end || *depthEnd != ' ' || countError != std::errc{} || countEnd != end) {
+                std::cerr << "Unable to parse EPD line " << lineNumber << ": " << line << "\nInvalid depth field: '" << field << "'\n";
+                throw std::runtime_error("Invalid EPD.");
+            }
+            entry.expected.at(depth) = count;
+        }
+        return true;
+    }
+
+    // Check every listed depth of entry up to maxNodes on game, reporting mismatches to stderr.
+    void checkEntry(Game& game, const EpdEntry& entry, uint64_t maxNodes, Totals& totals) {
+        try {
+            game.loadFEN(entry.FEN);
+        } catch(const std::runtime_error&) {
+            std::cerr << "\nLine " + std::to_string(entry.lineNumber) + ": FAILED to load the FEN\n";
+            totals.failures++;
+            return;
+        }
+
+        for(int depth = 1; depth <= MAX_EPD_DEPTH; depth++) {
+            const std::optional<uint64_t> listed = entry.expected.at(depth);
+            if(!listed.has_value() || *listed > maxNodes) {
+                continue;
+            }
+            const uint64_t expected = *listed;
+            const uint64_t nodes = Perft::perftBulk(game, depth);
+            totals.depths++;
+            totals.nodes += nodes;
+            if(nodes != expected) {
+                // One write per line, so lines from different threads do not interleave.
+                std::cerr << "Line " + std::to_string(entry.lineNumber) + ": Ply " + std::to_string(depth) + ": " + std::to_string(nodes)
+                    + " moves, expected " + std::to_string(expected) + " FAILED: " + std::string{entry.FEN} + "\n";
+                totals.failures++;
+            }
+        }
+        totals.positions++;
+    }
+
+    // Check every entry of a chunk on numThreads threads, each with its own game.
+    void checkEntries(const std::vector<EpdEntry>& entries, const Options& options, Totals& totals) {
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            Game game;
+            for(size_t taken = next++; taken < entries.size(); taken = next++) {
+                checkEntry(game, entries[taken], options.maxNodes, totals);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for(int thread = 1; thread < options.numThreads; thread++) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for(std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Stream the file a chunk at a time and check the complete lines of each chunk. A line cut off at the end of a
+    // chunk is moved to the front of the buffer and finished by the next read.
+    void checkFile(std::ifstream& file, const Options& options, Totals& totals) {
+        std::vector<char> buffer(CHUNK_BYTES);
+        std::vector<EpdEntry> entries;
+        size_t carried = 0;
+        size_t lineNumber = 0;
+        while(true) {
+            file.read(buffer.data() + carried, static_cast<std::streamsize>(buffer.size() - carried));
+            const size_t size = carried + static_cast<size_t>(file.gcount());
+            const bool lastChunk = size < buffer.size();
+            const std::string_view chunk{buffer.data(), size};
+
+            entries.clear();
+            size_t lineStart = 0;
+            for(size_t lineEnd = chunk.find('\n'); lineEnd != std::string_view::npos; lineEnd = chunk.find('\n', lineStart)) {
+                EpdEntry entry;
+                if(parseLine(chunk.substr(lineStart, lineEnd - lineStart), ++lineNumber, entry)) {
+                    entries.push_back(entry);
+                }
+                lineStart = lineEnd + 1;
+            }
+            // The file may not end with a newline
+            if(lastChunk && lineStart < size) {
+                EpdEntry entry;
+                if(parseLine(chunk.substr(lineStart), ++lineNumber, entry)) {
+                    entries.push_back(entry);
+                }
+                lineStart = size;
+            }
+            if(!lastChunk && lineStart == 0) {
+                std::cerr << "EPD line " << lineNumber + 1 << " is longer than " << CHUNK_BYTES << " bytes\n";
+                throw std::runtime_error("Invalid EPD.");
+            }
+
+            checkEntries(entries, options, totals);
+
+            if(lastChunk) {
+                return;
+            }
+            carried = size - lineStart;
+            std::memmove(buffer.data(), buffer.data() + lineStart, carried);
+        }
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    const Options options = parseOptions(argc, argv);
+
+    std::ifstream file(options.path, std::ios::binary);
+    if(!file) {
+        std::cerr << "Unable to open EPD file: " << options.path << "\n";
+        throw std::runtime_error("Invalid arguments.");
+    }
+
+    Totals totals;
+    PerfCounters counters;
+    counters.start();
+    const auto start = std::chrono::steady_clock::now();
+    checkFile(file, options, totals);
+    counters.stop();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    constexpr double NODES_PER_MEGANODE = 1'000'000;
+    std::cout << totals.positions << " positions, " << totals.depths << " depths, " << totals.nodes << " nodes on " << options.numThreads
+        << " threads in " << seconds << "s: " << static_cast<double>(totals.nodes) / seconds / NODES_PER_MEGANODE << " Mnps\n";
+    counters.printPerNode(std::cout, totals.nodes);
+    if(totals.failures > 0) {
+        std::cout << totals.failures << " FAILED\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "All positions ok\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+// Checks every known perft position at every depth up to a node budget, with the (position, depth) pairs spread over
+// all cores. Prints nodes, wall time, and NPS of every pair as CSV or JSON on stdout, and hardware counters per node
+// on stderr where available; exits non-zero on any mismatch.
+//
+// Usage: perftSuiteRunner [--format csv|json] [--threads N] [--max-nodes N]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/engine/PerfCounters.hpp"
+#include "Perft.hpp"
+#include "PerftPositions.hpp"
+
+namespace {
+    // One (position, depth) pair to count, and what it measured.
+    struct PerftJob {
+        const PerftPosition* position{nullptr};
+        int depth{0};
+        uint64_t nodes{0};
+        double seconds{0};
+
+        uint64_t expected() const { return position->perfts.at(depth); }
+        bool passed() const { return nodes == expected(); }
+        double nps() const { return seconds > 0 ? static_cast<double>(nodes) / seconds : 0; }
+    };
+
+    struct Options {
+        std::string format{"csv"};
+        int numThreads{std::max(1, static_cast<int>(std::thread::hardware_concurrency()))};
+        // Depths whose expected count is larger are skipped.
+        uint64_t maxNodes{200'000'000}; // NOLINT(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers) about a second of bulk perft
+    };
+
+    // Parse the command line. Throws on unknown or malformed arguments.
+    Options parseOptions(int argc, char** argv) {
+        Options options;
+        const std::vector<std::string> args(argv + 1, argv + argc);
+        for(size_t i = 0; i < args.size(); i++) {
+            const bool hasValue = i + 1 < args.size();
+            if(args[i] == "--format" && hasValue) {
+                options.format = args[++i];
+            } else if(args[i] == "--threads" && hasValue) {
+                options.numThreads = std::max(1, std::stoi(args[++i]));
+            } else if(args[i] == "--max-nodes" && hasValue) {
+                options.maxNodes = std::stoull(args[++i]);
+            } else {
+                std::cerr << "Unknown argument: " << args[i] << "\n";
+                throw std::runtime_error("Invalid arguments.");
+            }
+        }
+        if(options.format != "csv" && options.format != "json") {
+            std::cerr << "Unknown format: " << options.format << ", expected csv or json\n";
+            throw std::runtime_error("Invalid arguments.");
+        }
+        return options;
+    }
+
+    // Count every job on numThreads threads. Jobs are taken biggest first, so the long ones do not start last.
+    void runJobs(std::vector<PerftJob>& jobs, int numThreads) {
+        std::vector<size_t> order(jobs.size());
+        for(size_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return jobs[a].expected() > jobs[b].expected(); }); // NOLINT(readability-identifier-length)
+
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            for(size_t taken = next++; taken < order.size(); taken = next++) {
+                PerftJob& job = jobs[order[taken]];
+                Game game;
+                game.loadFEN(job.position->FEN);
+
+                const auto start = std::chrono::steady_clock::now();
+                job.nodes = Perft::perftBulk(game, job.depth);
+                job.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                // One write per line, so lines from different threads do not interleave.
+                std::cerr << job.position->name + ": Ply " + std::to_string(job.depth) + ": " + std::to_string(job.nodes) + " moves" + (job.passed() ? "" : " FAILED") + "\n";
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for(int thread = 1; thread < numThreads; thread++) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for(std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void printCsv(const std::vector<PerftJob>& jobs) {
+        std::cout << "position,depth,nodes,expected,ok,seconds,nps\n";
+        for(const PerftJob& job : jobs) {
+            std::cout << '"' << job.position->name << "\"," << job.depth << ',' << job.nodes << ',' << job.expected() << ','
+                << (job.passed() ? "true" : "false") << ',' << job.seconds << ',' << static_cast<uint64_t>(job.nps()) << "\n";
+        }
+    }
+
+    void printJson(const std::vector<PerftJob>& jobs) {
+        std::cout << "[\n";
+        for(size_t i = 0; i < jobs.size(); i++) {
+            const PerftJob& job = jobs[i];
+            std::cout << "  {\"position\": \"" << job.position->name << "\", \"depth\": " << job.depth << ", \"nodes\": " << job.nodes
+                << ", \"expected\": " << job.expected() << ", \"ok\": " << (job.passed() ? "true" : "false")
+                << ", \"seconds\": " << job.seconds << ", \"nps\": " << static_cast<uint64_t>(job.nps()) << "}"
+                << (i + 1 < jobs.size() ? "," : "") << "\n";
+        }
+        std::cout << "]\n";
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    const Options options = parseOptions(argc, argv);
+
+    std::vector<PerftJob> jobs;
+    for(const PerftPosition& position : PERFT_POSITIONS) {
+        for(int depth = 1; depth < static_cast<int>(position.perfts.size()) && position.perfts[depth] <= options.maxNodes; depth++) {
+            jobs.push_back(PerftJob{&position, depth});
+        }
+    }
+
+    PerfCounters counters;
+    counters.start();
+    const auto start = std::chrono::steady_clock::now();
+    runJobs(jobs, options.numThreads);
+    counters.stop();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if(options.format == "json") {
+        printJson(jobs);
+    } else {
+        printCsv(jobs);
+    }
+
+    const bool allPassed = std::all_of(jobs.begin(), jobs.end(), [](const PerftJob& job) { return job.passed(); });
+    std::cerr << jobs.size() << " position / depth pairs on " << options.numThreads << " threads in " << seconds << "s: "
+        << (allPassed ? "ok" : "FAILED") << "\n";
+    uint64_t nodes = 0;
+    for(const PerftJob& job : jobs) {
+        nodes += job.nodes;
+    }
+    counters.printPerNode(std::cerr, nodes);
+    return allPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,69 +1,240 @@
 // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers) this file has arbitrary maxDepths
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
+#include <thread>
+#include <tuple>
 #include <vector>
 
 #include "Perft.hpp"
+#include "PerftPositions.hpp"
 
-// All positions from https://www.chessprogramming.org/Perft_Results
-// All perft maps are std::array where ply = num positions (ply 0 -> 0)
+// Depths are counted with the hashed perft; up to this depth, the bulk and exhaustive perfts must agree with it.
+constexpr int CROSS_CHECK_MAX_DEPTH = 4;
+// Size of the perft hash table shared by every position.
+constexpr size_t PERFT_TABLE_MEGABYTES = 256;
 
-bool checkPosition(const std::vector<uint64_t>& perfMap, const std::string& name, const std::string& FEN, int maxDepth) {
+bool checkPosition(const std::vector<uint64_t>& perfMap, const std::string& name, const std::string& FEN, int maxDepth, PerftTable& table) {
     // init game
     Game game;
     game.loadFEN(FEN);
+    // counts cached for the previous position are still right, but would only crowd out this position's entries
+    table.clear();
     for(int depth = 1; depth <= maxDepth; depth++) {
         const uint64_t expectedNumPositions = perfMap.at(depth);
-        const uint64_t numPositions = Perft::perft(game, depth);
+        const uint64_t numPositions = Perft::perftHashed(game, depth, table);
         
         if(numPositions != expectedNumPositions) {
             std::cerr << name << ": Got numPositions " << numPositions << ", expected " << expectedNumPositions << "\n";
             return false;
         }
+        if(depth <= CROSS_CHECK_MAX_DEPTH && (Perft::perftBulk(game, depth) != numPositions || Perft::perft(game, depth) != numPositions)) {
+            std::cerr << name << ": Hashed, bulk, and exhaustive perft disagree at ply " << depth << "\n";
+            return false;
+        }
         std::cerr << name << ": Ply " << depth << ": " << numPositions << " moves" << "\n";
     }
 
     return true;
 }
 
-int main() {
-    const std::vector<uint64_t> positionStartPerfts{0, 20, 400, 8'902, 197'281, 4'865'609, 119'060'324, 3'195'901'860, 84'998'978'956, 2'439'530'234'167, 69'352'859'712'417, 2'097'651'003'696'806,62'854'969'236'701'747};
-    const std::vector<uint64_t> positionPawnPromotionPerfts{0, 11, 31, 402, 2'149, 31'227, 162'168, 2'840'871, 15'302'788, 303'554'661};
-    const std::vector<uint64_t> position2Perfts {0, 48, 2'039, 97'862, 4'085'603, 193'690'690, 8'031'647'685};
-    const std::vector<uint64_t> position3Perfts {0, 14, 191, 2'812, 43'238, 674'624, 11'030'083, 178'633'661, 3'009'794'393};
-    const std::vector<uint64_t> position4Perfts {0, 6, 264, 9'467, 422'333, 15'833'292, 706'045'033};
-    const std::vector<uint64_t> position5Perfts {0, 44, 1'486, 62'379, 2'103'487, 89'941'194};
-    const std::vector<uint64_t> position6Perfts {0, 46, 2'079, 89'890, 3'894'594, 164'075'551, 6'923'051'137, 287'188'994'746, 11'923'589'843'526, 490'154'852'788'714};
-
-    // we test all of these to a max of ~200,000,000, which is about 10s each
-    if(!checkPosition(positionStartPerfts, "Start Position", std::string{Utils::STARTING_FEN}, 6)) {
-        return EXIT_FAILURE;
+// Check a single depth of a position built around one move generation edge case. These are small, so both perft
+// modes run to the full depth.
+bool checkEdgeCase(const std::string& name, const std::string& FEN, int depth, uint64_t expectedNumPositions) {
+    Game game;
+    game.loadFEN(FEN);
+    const uint64_t numPositions = Perft::perftBulk(game, depth);
+
+    if(numPositions != expectedNumPositions || Perft::perft(game, depth) != numPositions) {
+        std::cerr << name << ": Got numPositions " << numPositions << ", expected " << expectedNumPositions << "\n";
+        return false;
     }
+    std::cerr << name << ": Ply " << depth << ": " << numPositions << " moves" << "\n";
+    return true;
+}
 
-    if(!checkPosition(positionPawnPromotionPerfts, "Pawn Promotion", "7k/P7/1K6/8/8/8/8/8 w - - 0 1", 8)) {
-        return EXIT_FAILURE;
+bool containsMove(const MoveList& moves, const Move& move) {
+    for(int i = 0; i < moves.size; i++) {
+        if(moves.data[i] == move) {
+            return true;
+        }
     }
+    return false;
+}
 
-    if(!checkPosition(position2Perfts, "Position 2", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -", 5)) {
-        return EXIT_FAILURE;
+// Walk every position up to depth and check the staged generators split the legal moves between them exactly.
+bool checkStagedGeneration(Game& game, int depth) { // NOLINT(misc-no-recursion)
+    MoveList legalMoves;
+    MoveList captures;
+    MoveList quiets;
+    game.generateLegalMoves(legalMoves);
+    game.generateCaptures(captures);
+    game.generateQuiets(quiets);
+
+    if(captures.size + quiets.size != legalMoves.size) {
+        std::cerr << "Staged generation: " << captures.size << " captures + " << quiets.size << " quiets, expected " << legalMoves.size << " legal moves\n" << game.to_string() << "\n";
+        return false;
+    }
+    for(int i = 0; i < captures.size; i++) {
+        const Move move = captures.data[i];
+        if(!(move.isCapture() || move.isPromotion()) || !containsMove(legalMoves, move)) {
+            std::cerr << "Staged generation: bad capture " << move.toLongAlgebraic() << "\n" << game.to_string() << "\n";
+            return false;
+        }
+    }
+    for(int i = 0; i < quiets.size; i++) {
+        const Move move = quiets.data[i];
+        if(move.isCapture() || move.isPromotion() || !containsMove(legalMoves, move)) {
+            std::cerr << "Staged generation: bad quiet " << move.toLongAlgebraic() << "\n" << game.to_string() << "\n";
+            return false;
+        }
     }
 
-    if(!checkPosition(position3Perfts, "Position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 7)) {
-        return EXIT_FAILURE;
+    if(game.inCheck()) {
+        MoveList evasions;
+        game.generateEvasions(evasions);
+        if(evasions.size != legalMoves.size) {
+            std::cerr << "Staged generation: " << evasions.size << " evasions, expected " << legalMoves.size << "\n" << game.to_string() << "\n";
+            return false;
+        }
     }
 
-    if(!checkPosition(position4Perfts, "Position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5)) {
-        return EXIT_FAILURE;
+    if(depth <= 1) {
+        return true;
     }
+    StateInfo saved;
+    for(int i = 0; i < legalMoves.size; i++) {
+        const Move move = legalMoves.data[i];
+        game.makeMove(move, saved);
+        const bool ok = checkStagedGeneration(game, depth - 1);
+        game.unmakeMove(move, saved);
+        if(!ok) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    if(!checkPosition(position5Perfts, "Position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5)) {
-        return EXIT_FAILURE;
+// Filtering pseudo legal moves with doesMovePutUsInCheck must leave exactly the legal moves.
+bool checkPseudoLegalFilter(Game& game, int depth) { // NOLINT(misc-no-recursion)
+    MoveList legalMoves;
+    game.generateLegalMoves(legalMoves);
+    MoveList pseudoLegalMoves;
+    game.generatePseudoLegalMoves(pseudoLegalMoves);
+
+    int numLegal = 0;
+    StateInfo saved;
+    for(int i = 0; i < pseudoLegalMoves.size; i++) {
+        const Move move = pseudoLegalMoves.data[i];
+        game.makeMove(move, saved);
+        const bool putsUsInCheck = game.doesMovePutUsInCheck(move);
+        game.unmakeMove(move, saved);
+
+        if(putsUsInCheck == containsMove(legalMoves, move)) {
+            std::cerr << "Pseudo legal filter: wrong verdict for " << move.toLongAlgebraic() << "\n" << game.to_string() << "\n";
+            return false;
+        }
+        numLegal += putsUsInCheck ? 0 : 1;
+    }
+    if(numLegal != legalMoves.size) {
+        std::cerr << "Pseudo legal filter: " << numLegal << " moves kept, expected " << legalMoves.size << "\n" << game.to_string() << "\n";
+        return false;
     }
 
-    if(!checkPosition(position6Perfts, "Position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 5)) {
+    if(depth <= 1) {
+        return true;
+    }
+    for(int i = 0; i < legalMoves.size; i++) {
+        const Move move = legalMoves.data[i];
+        game.makeMove(move, saved);
+        const bool ok = checkPseudoLegalFilter(game, depth - 1);
+        game.unmakeMove(move, saved);
+        if(!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    // with the hash table, we test these to a max of ~8,000,000,000 nodes, which is under a minute for all of them
+    PerftTable table(PERFT_TABLE_MEGABYTES);
+    for(const PerftPosition& position : PERFT_POSITIONS) {
+        if(!checkPosition(position.perfts, position.name, position.FEN, position.suiteDepth, table)) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Pins, checks, and en passant / castling edge cases; see http://www.talkchess.com/forum3/viewtopic.php?t=47318
+    const bool edgeCasesPass =
+        checkEdgeCase("Illegal en passant 1", "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1", 6, 1'134'888) &&
+        checkEdgeCase("Illegal en passant 2", "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1", 6, 1'015'133) &&
+        checkEdgeCase("En passant gives check", "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1", 6, 1'440'467) &&
+        checkEdgeCase("Castle gives check", "5k2/8/8/8/8/8/8/4K2R w K - 0 1", 6, 661'072) &&
+        checkEdgeCase("Long castle gives check", "3k4/8/8/8/8/8/8/R3K3 w Q - 0 1", 6, 803'711) &&
+        checkEdgeCase("Castling rights", "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1", 4, 1'274'206) &&
+        checkEdgeCase("Castling prevented", "r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1", 4, 1'720'476) &&
+        checkEdgeCase("Promote out of check", "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1", 6, 3'821'001) &&
+        checkEdgeCase("Discovered check", "8/8/1P2K3/8/2n5/1q6/8/5k2 b - - 0 1", 5, 1'004'658) &&
+        checkEdgeCase("Promote to give check", "4k3/1P6/8/8/8/8/K7/8 w - - 0 1", 6, 217'342) &&
+        checkEdgeCase("Underpromote to check", "8/P1k5/K7/8/8/8/8/8 w - - 0 1", 6, 92'683) &&
+        checkEdgeCase("Self stalemate", "K1k5/8/P7/8/8/8/8/8 w - - 0 1", 6, 2'217) &&
+        checkEdgeCase("Stalemate and checkmate", "8/k1P5/8/1K6/8/8/8/8 w - - 0 1", 7, 567'584) &&
+        checkEdgeCase("Double check", "8/8/2k5/5q2/5n2/8/5K2/8 b - - 0 1", 4, 23'527);
+    if(!edgeCasesPass) {
         return EXIT_FAILURE;
     }
+
+    // Captures, quiets, and evasions must add up to the legal moves
+    for(const std::string& FEN : {
+        std::string{Utils::STARTING_FEN},
+        std::string{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -"},
+        std::string{"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"},
+        std::string{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"},
+        std::string{"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"}
+    }) {
+        Game game;
+        game.loadFEN(FEN);
+        if(!checkStagedGeneration(game, 3)) {
+            return EXIT_FAILURE;
+        }
+    }
+    std::cerr << "Staged generation: ok\n";
+
+    // Make / test / unmake filtering, including castling out of, through, and into check
+    for(const std::string& FEN : {
+        std::string{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -"},
+        std::string{"r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1"},
+        std::string{"r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1"},
+        std::string{"3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1"}
+    }) {
+        Game game;
+        game.loadFEN(FEN);
+        if(!checkPseudoLegalFilter(game, 3)) {
+            return EXIT_FAILURE;
+        }
+    }
+    std::cerr << "Pseudo legal filter: ok\n";
+
+    // Splitting the tree over threads must not change the counts, with or without a shared table
+    const int numThreads = std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+    for(const auto& [FEN, depth, expectedNumPositions] : {
+        std::tuple<std::string, int, uint64_t>{std::string{Utils::STARTING_FEN}, 6, 119'060'324},
+        std::tuple<std::string, int, uint64_t>{"7k/P7/1K6/8/8/8/8/8 w - - 0 1", 7, 2'840'871},
+        std::tuple<std::string, int, uint64_t>{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -", 5, 193'690'690}
+    }) {
+        Game game;
+        game.loadFEN(FEN);
+        table.clear();
+        const uint64_t numPositions = Perft::perftParallel(game, depth, numThreads);
+        const uint64_t numPositionsHashed = Perft::perftParallel(game, depth, numThreads, &table);
+        if(numPositions != expectedNumPositions || numPositionsHashed != expectedNumPositions) {
+            std::cerr << "Parallel perft: got " << numPositions << " and " << numPositionsHashed << " (hashed), expected " << expectedNumPositions << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    std::cerr << "Parallel perft: ok\n";
 }
 
 // NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
\ No newline at end of file